@@ -0,0 +1,78 @@
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// -------------------------------------------------------
+// Name:        Barrier
+// Description: Holds a fixed group of threads until all
+//              of them have arrived, then lets them go
+//              together. It can be reused straight away.
+// -------------------------------------------------------
+class Barrier {
+private:
+
+// -------------------------------------------------------
+// Description: The number of threads in the group, and
+//              how many have still to arrive this round.
+// -------------------------------------------------------
+    int m_threads;
+    int m_waiting;
+
+// -------------------------------------------------------
+// Description: Counts the rounds, so a thread that wakes
+//              late can tell its round is over.
+// -------------------------------------------------------
+    unsigned int m_generation;
+
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+
+public:
+    explicit Barrier( int threads ) : m_threads( threads ), m_waiting( threads ), m_generation( 0 ) {
+    }
+
+    void wait();
+};
+
+// ----------------------------------------------------------------
+//  Name:           wait
+//  Description:    Blocks until every thread in the group has called
+//                  wait for this round.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void Barrier::wait() {
+    std::unique_lock<std::mutex> lock( m_mutex );
+    unsigned int generation = m_generation;
+    m_waiting--;
+    if( m_waiting == 0 ) {
+        // last one in starts the next round and wakes the rest.
+        m_generation++;
+        m_waiting = m_threads;
+        m_released.notify_all();
+    }
+    else {
+        while( generation == m_generation ) {
+            m_released.wait( lock );
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           workerCount
+//  Description:    Picks how many threads a parallel search uses.
+//  Arguments:      The number asked for, or 0 for one per core.
+//  Return Value:   The number of threads, at least 1.
+// ----------------------------------------------------------------
+inline int workerCount( int requested ) {
+    if( requested > 0 ) {
+        return requested;
+    }
+    int cores = (int)std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+#endif
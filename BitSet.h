@@ -0,0 +1,174 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+typedef unsigned long long BitWord;
+
+// ----------------------------------------------------------------
+//  Name:           popCount
+//  Description:    Counts the set bits in a word.
+//  Arguments:      The word to count.
+//  Return Value:   The number of set bits.
+// ----------------------------------------------------------------
+inline int popCount( BitWord word ) {
+#ifdef _MSC_VER
+    return (int)__popcnt64( word );
+#else
+    return __builtin_popcountll( word );
+#endif
+}
+
+// ----------------------------------------------------------------
+//  Name:           lowestBit
+//  Description:    Finds the position of the lowest set bit.
+//  Arguments:      The word to search, which must not be 0.
+//  Return Value:   The bit position, 0 to 63.
+// ----------------------------------------------------------------
+inline int lowestBit( BitWord word ) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64( &index, word );
+    return (int)index;
+#else
+    return __builtin_ctzll( word );
+#endif
+}
+
+// ----------------------------------------------------------------
+//  Name:           highestBit
+//  Description:    Finds the position of the highest set bit.
+//  Arguments:      The word to search, which must not be 0.
+//  Return Value:   The bit position, 0 to 63.
+// ----------------------------------------------------------------
+inline int highestBit( BitWord word ) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64( &index, word );
+    return (int)index;
+#else
+    return 63 - __builtin_clzll( word );
+#endif
+}
+
+// -------------------------------------------------------
+// Name:        BitSet
+// Description: A fixed size set of bits stored as 64 bit
+//              words, so whole words can be combined at
+//              once.
+// -------------------------------------------------------
+class BitSet {
+private:
+
+// -------------------------------------------------------
+// Description: The words holding the bits.
+// -------------------------------------------------------
+    std::vector<BitWord> m_words;
+
+// -------------------------------------------------------
+// Description: The number of bits in the set.
+// -------------------------------------------------------
+    int m_size;
+
+public:
+    BitSet() : m_size( 0 ) {
+    }
+
+    explicit BitSet( int size ) : m_words( ( size + 63 ) / 64, 0 ), m_size( size ) {
+    }
+
+    // Accessor functions
+    int size() const {
+        return m_size;
+    }
+
+    int wordCount() const {
+        return (int)m_words.size();
+    }
+
+    BitWord word( int index ) const {
+        return m_words[index];
+    }
+
+    bool test( int bit ) const {
+        return ( m_words[bit >> 6] >> ( bit & 63 ) ) & 1;
+    }
+
+    // Manipulator functions
+    void resize( int size ) {
+        m_words.assign( ( size + 63 ) / 64, 0 );
+        m_size = size;
+    }
+
+    void set( int bit ) {
+        m_words[bit >> 6] |= BitWord( 1 ) << ( bit & 63 );
+    }
+
+    void reset( int bit ) {
+        m_words[bit >> 6] &= ~( BitWord( 1 ) << ( bit & 63 ) );
+    }
+
+    void clear() {
+        m_words.assign( m_words.size(), 0 );
+    }
+
+    BitWord& word( int index ) {
+        return m_words[index];
+    }
+
+    int count() const;
+    void unite( BitSet const & other );
+    void swap( BitSet & other );
+};
+
+// ----------------------------------------------------------------
+//  Name:           count
+//  Description:    Counts every set bit.
+//  Arguments:      None.
+//  Return Value:   The number of set bits.
+// ----------------------------------------------------------------
+inline int BitSet::count() const {
+    int total = 0;
+    for( size_t i = 0; i < m_words.size(); i++ ) {
+        total += popCount( m_words[i] );
+    }
+    return total;
+}
+
+// ----------------------------------------------------------------
+//  Name:           unite
+//  Description:    Sets every bit that is set in the other set.
+//  Arguments:      A set of the same size.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void BitSet::unite( BitSet const & other ) {
+    if( m_words.empty() ) {
+        return;
+    }
+    BitWord* pWords = &m_words[0];
+    BitWord const* pOther = &other.m_words[0];
+    int words = (int)m_words.size();
+    // plain word loop, so the compiler can vectorise it.
+    for( int i = 0; i < words; i++ ) {
+        pWords[i] |= pOther[i];
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           swap
+//  Description:    Swaps the contents of two sets.
+//  Arguments:      The set to swap with.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void BitSet::swap( BitSet & other ) {
+    m_words.swap( other.m_words );
+    int size = m_size;
+    m_size = other.m_size;
+    other.m_size = size;
+}
+
+#endif
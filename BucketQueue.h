@@ -0,0 +1,261 @@
+#ifndef BUCKETQUEUE_H
+#define BUCKETQUEUE_H
+
+#include <vector>
+#include <deque>
+#include <utility>
+
+#include "BitSet.h"
+
+// -------------------------------------------------------
+// Name:        DialQueue
+// Description: A monotone priority queue of (cost, node)
+//              entries for arc weights from 0 to a known
+//              maximum (Dial's algorithm). Costs can only
+//              be pushed from the last popped cost up to
+//              that plus the maximum weight, so a ring of
+//              maximum + 1 buckets, one per cost, holds
+//              them all and the cursor only moves forwards.
+//              It has the same push/top/pop/empty calls as
+//              std::priority_queue.
+// -------------------------------------------------------
+class DialQueue {
+private:
+    typedef std::pair<int, int> Entry;
+
+// -------------------------------------------------------
+// Description: The nodes queued at each cost, by cost
+//              modulo the number of buckets.
+// -------------------------------------------------------
+    std::vector< std::vector<int> > m_buckets;
+
+// -------------------------------------------------------
+// Description: The cost under the cursor, and how many
+//              entries are queued.
+// -------------------------------------------------------
+    int m_cost;
+    int m_size;
+
+    void advance();
+
+public:
+    explicit DialQueue( int maxWeight ) : m_buckets( maxWeight + 1 ), m_cost( 0 ), m_size( 0 ) {
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    void push( Entry const & entry ) {
+        m_buckets[entry.first % m_buckets.size()].push_back( entry.second );
+        m_size++;
+    }
+
+    Entry top() {
+        advance();
+        return Entry( m_cost, m_buckets[m_cost % m_buckets.size()].back() );
+    }
+
+    void pop() {
+        advance();
+        m_buckets[m_cost % m_buckets.size()].pop_back();
+        m_size--;
+    }
+};
+
+// ----------------------------------------------------------------
+//  Name:           advance
+//  Description:    Moves the cursor to the cheapest queued cost.
+//                  The queue must not be empty.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void DialQueue::advance() {
+    while( m_buckets[m_cost % m_buckets.size()].empty() ) {
+        m_cost++;
+    }
+}
+
+// -------------------------------------------------------
+// Name:        RadixHeap
+// Description: A monotone priority queue of (cost, node)
+//              entries for any non-negative costs. Bucket
+//              i holds costs whose highest bit differing
+//              from the last popped cost is bit i - 1, so
+//              each entry moves down at most once per bit.
+//              It has the same push/top/pop/empty calls as
+//              std::priority_queue.
+// -------------------------------------------------------
+class RadixHeap {
+private:
+    typedef std::pair<int, int> Entry;
+
+    std::vector<Entry> m_buckets[33];
+
+// -------------------------------------------------------
+// Description: The last cost taken out, and how many
+//              entries are queued.
+// -------------------------------------------------------
+    int m_last;
+    int m_size;
+
+    int bucketOf( int cost ) const {
+        unsigned int bits = (unsigned int)( cost ^ m_last );
+        return bits == 0 ? 0 : highestBit( bits ) + 1;
+    }
+
+    void refill();
+
+public:
+    RadixHeap() : m_last( 0 ), m_size( 0 ) {
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    void push( Entry const & entry ) {
+        m_buckets[bucketOf( entry.first )].push_back( entry );
+        m_size++;
+    }
+
+    Entry top() {
+        refill();
+        return m_buckets[0].back();
+    }
+
+    void pop() {
+        refill();
+        m_buckets[0].pop_back();
+        m_size--;
+    }
+};
+
+// ----------------------------------------------------------------
+//  Name:           refill
+//  Description:    If nothing is left at the last cost, takes the
+//                  lowest non-empty bucket, makes its cheapest cost
+//                  the last cost and spreads it into lower buckets.
+//                  The queue must not be empty.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void RadixHeap::refill() {
+    if( !m_buckets[0].empty() ) {
+        return;
+    }
+    int i = 1;
+    while( m_buckets[i].empty() ) {
+        i++;
+    }
+    std::vector<Entry>& bucket = m_buckets[i];
+    m_last = bucket[0].first;
+    for( size_t j = 1; j < bucket.size(); j++ ) {
+        if( bucket[j].first < m_last ) {
+            m_last = bucket[j].first;
+        }
+    }
+    for( size_t j = 0; j < bucket.size(); j++ ) {
+        m_buckets[bucketOf( bucket[j].first )].push_back( bucket[j] );
+    }
+    bucket.clear();
+}
+
+// -------------------------------------------------------
+// Name:        FifoQueue
+// Description: A plain first-in first-out queue of (cost,
+//              node) entries. When every arc weighs the same,
+//              costs come out in order anyway, so a uniform
+//              cost search over it is a breadth-first search.
+//              It has the same push/top/pop/empty calls as
+//              std::priority_queue.
+// -------------------------------------------------------
+class FifoQueue {
+private:
+    typedef std::pair<int, int> Entry;
+
+    std::deque<Entry> m_entries;
+
+public:
+    bool empty() const {
+        return m_entries.empty();
+    }
+
+    size_t size() const {
+        return m_entries.size();
+    }
+
+    void push( Entry const & entry ) {
+        m_entries.push_back( entry );
+    }
+
+    Entry top() const {
+        return m_entries.front();
+    }
+
+    void pop() {
+        m_entries.pop_front();
+    }
+};
+
+// -------------------------------------------------------
+// Name:        ZeroOneQueue
+// Description: The deque of 0-1 BFS, for arc weights that
+//              are all 0 or 1. An entry at the cost last
+//              taken out came over a 0 arc and goes on the
+//              front; anything else is one more and goes on
+//              the back, so the front is always cheapest.
+//              It has the same push/top/pop/empty calls as
+//              std::priority_queue.
+// -------------------------------------------------------
+class ZeroOneQueue {
+private:
+    typedef std::pair<int, int> Entry;
+
+    std::deque<Entry> m_entries;
+
+// -------------------------------------------------------
+// Description: The cost of the last entry taken out.
+// -------------------------------------------------------
+    int m_cost;
+
+public:
+    ZeroOneQueue() : m_cost( 0 ) {
+    }
+
+    bool empty() const {
+        return m_entries.empty();
+    }
+
+    size_t size() const {
+        return m_entries.size();
+    }
+
+    void push( Entry const & entry ) {
+        if( entry.first == m_cost ) {
+            m_entries.push_front( entry );
+        }
+        else {
+            m_entries.push_back( entry );
+        }
+    }
+
+    Entry top() const {
+        return m_entries.front();
+    }
+
+    void pop() {
+        m_cost = m_entries.front().first;
+        m_entries.pop_front();
+    }
+};
+
+#endif
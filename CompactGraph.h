@@ -0,0 +1,441 @@
+#ifndef COMPACTGRAPH_H
+#define COMPACTGRAPH_H
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+
+#include "NodeOrder.h"
+
+template <class NodeType, class ArcType> class GraphArc;
+template <class NodeType, class ArcType> class GraphNode;
+
+// -------------------------------------------------------
+// Name:        CompactGraph
+// Description: A packed, read-only copy of the arcs of a
+//              graph. The arcs of each node are stored next
+//              to each other in flat arrays, both forwards
+//              and reversed. Nodes get packed ids, which are
+//              the graph's node indices unless a NodeOrder
+//              renumbers them; internal() and external()
+//              convert between the two.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class CompactGraph {
+private:
+    typedef GraphNode<NodeType, ArcType> Node;
+
+// -------------------------------------------------------
+// Description: The arcs leaving node i are the entries
+//              m_offsets[i] up to m_offsets[i + 1] of
+//              m_targets and m_weights.
+// -------------------------------------------------------
+    vector<int> m_offsets;
+    vector<int> m_targets;
+    vector<ArcType> m_weights;
+
+// -------------------------------------------------------
+// Description: The same arcs grouped by the node they
+//              arrive at, for searches that look backwards.
+// -------------------------------------------------------
+    vector<int> m_inOffsets;
+    vector<int> m_sources;
+    vector<ArcType> m_inWeights;
+
+// -------------------------------------------------------
+// Description: The graph node behind each id (0 for ids
+//              with no node).
+// -------------------------------------------------------
+    vector<Node*> m_nodes;
+
+// -------------------------------------------------------
+// Description: Packed id of each graph index, and graph
+//              index of each packed id.
+// -------------------------------------------------------
+    vector<int> m_internal;
+    vector<int> m_external;
+
+// -------------------------------------------------------
+// Description: The lightest and heaviest arc weights, both
+//              0 when there are no arcs.
+// -------------------------------------------------------
+    ArcType m_minWeight;
+    ArcType m_maxWeight;
+
+    void order( Node** pNodes, int maxNodes, unordered_map<Node*, int> const & indices,
+                NodeOrder nodeOrder, vector< pair<double, double> > const * pPositions );
+
+public:
+    // Accessor functions
+    int size() const {
+        return (int)m_nodes.size();
+    }
+
+    int arcCount() const {
+        return (int)m_targets.size();
+    }
+
+    ArcType minWeight() const {
+        return m_minWeight;
+    }
+
+    ArcType maxWeight() const {
+        return m_maxWeight;
+    }
+
+    Node* node( int id ) const {
+        return m_nodes[id];
+    }
+
+    int firstArc( int id ) const {
+        return m_offsets[id];
+    }
+
+    int endArc( int id ) const {
+        return m_offsets[id + 1];
+    }
+
+    int target( int arc ) const {
+        return m_targets[arc];
+    }
+
+    ArcType weight( int arc ) const {
+        return m_weights[arc];
+    }
+
+    int firstInArc( int id ) const {
+        return m_inOffsets[id];
+    }
+
+    int endInArc( int id ) const {
+        return m_inOffsets[id + 1];
+    }
+
+    int source( int inArc ) const {
+        return m_sources[inArc];
+    }
+
+    ArcType inWeight( int inArc ) const {
+        return m_inWeights[inArc];
+    }
+
+    int degree( int id ) const {
+        return m_offsets[id + 1] - m_offsets[id];
+    }
+
+    int internal( int index ) const {
+        return m_internal[index];
+    }
+
+    int external( int id ) const {
+        return m_external[id];
+    }
+
+    template<class Func>
+    void forEachArc( int id, Func func ) const {
+        for( int arc = m_offsets[id]; arc != m_offsets[id + 1]; arc++ ) {
+            func( m_targets[arc], m_weights[arc] );
+        }
+    }
+
+    unsigned long long memoryBytes() const {
+        return ( m_offsets.capacity() + m_targets.capacity() + m_inOffsets.capacity() + m_sources.capacity() +
+                 m_internal.capacity() + m_external.capacity() ) * sizeof( int ) +
+               ( m_weights.capacity() + m_inWeights.capacity() ) * sizeof( ArcType ) +
+               m_nodes.capacity() * sizeof( Node* );
+    }
+
+    void build( Node** pNodes, int maxNodes, unordered_map<Node*, int> const & indices,
+                NodeOrder nodeOrder = ORDER_INDEX, vector< pair<double, double> > const * pPositions = 0 );
+    void insertArc( int from, int to, ArcType weight );
+    void eraseArc( int from, int to );
+    void setNode( int id, Node* pNode );
+};
+
+// ----------------------------------------------------------------
+//  Name:           order
+//  Description:    Works out the packed id of every node. When
+//                  reordering, empty slots go last.
+//  Arguments:      The first argument is the graph's node array.
+//                  The second argument is the size of that array.
+//                  The third argument maps each node to its index.
+//                  The fourth argument is the numbering to use.
+//                  The fifth argument is the position of each node
+//                  by index, needed for ORDER_HILBERT.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void CompactGraph<NodeType, ArcType>::order( Node** pNodes, int maxNodes, unordered_map<Node*, int> const & indices,
+                                             NodeOrder nodeOrder, vector< pair<double, double> > const * pPositions ) {
+    int index;
+    m_external.clear();
+    m_external.reserve( maxNodes );
+
+    if( nodeOrder == ORDER_HILBERT && pPositions != 0 && (int)pPositions->size() >= maxNodes ) {
+        // scale the positions onto the curve's grid.
+        double minX = 0, minY = 0, maxX = 0, maxY = 0;
+        bool first = true;
+        for( index = 0; index < maxNodes; index++ ) {
+            if( pNodes[index] != 0 ) {
+                pair<double, double> const & p = (*pPositions)[index];
+                if( first || p.first < minX ) minX = p.first;
+                if( first || p.first > maxX ) maxX = p.first;
+                if( first || p.second < minY ) minY = p.second;
+                if( first || p.second > maxY ) maxY = p.second;
+                first = false;
+            }
+        }
+        double scaleX = maxX > minX ? 65535.0 / ( maxX - minX ) : 0;
+        double scaleY = maxY > minY ? 65535.0 / ( maxY - minY ) : 0;
+        vector< pair<unsigned long long, int> > keys;
+        for( index = 0; index < maxNodes; index++ ) {
+            if( pNodes[index] != 0 ) {
+                pair<double, double> const & p = (*pPositions)[index];
+                keys.push_back( make_pair( hilbertIndex( (unsigned int)( ( p.first - minX ) * scaleX ),
+                                                         (unsigned int)( ( p.second - minY ) * scaleY ) ), index ) );
+            }
+        }
+        sort( keys.begin(), keys.end() );
+        for( size_t i = 0; i < keys.size(); i++ ) {
+            m_external.push_back( keys[i].second );
+        }
+    }
+    else if( nodeOrder == ORDER_BFS || nodeOrder == ORDER_RCM ) {
+        // neighbours either way round, since arcs may be one way.
+        vector< vector<int> > links( maxNodes );
+        for( index = 0; index < maxNodes; index++ ) {
+            if( pNodes[index] != 0 ) {
+                typename list< GraphArc<NodeType, ArcType> >::const_iterator iter = pNodes[index]->arcList().begin();
+                typename list< GraphArc<NodeType, ArcType> >::const_iterator endIter = pNodes[index]->arcList().end();
+                for( ; iter != endIter; ++iter ) {
+                    int to = indices.find( (*iter).node() )->second;
+                    links[index].push_back( to );
+                    links[to].push_back( index );
+                }
+            }
+        }
+
+        // Cuthill-McKee starts each component at a lowest degree node
+        // and takes neighbours lowest degree first.
+        vector<int> starts;
+        for( index = 0; index < maxNodes; index++ ) {
+            if( pNodes[index] != 0 ) {
+                starts.push_back( index );
+            }
+        }
+        if( nodeOrder == ORDER_RCM ) {
+            for( index = 0; index < maxNodes; index++ ) {
+                vector<int>& l = links[index];
+                vector< pair<int, int> > byDegree;
+                for( size_t i = 0; i < l.size(); i++ ) {
+                    byDegree.push_back( make_pair( (int)links[l[i]].size(), l[i] ) );
+                }
+                sort( byDegree.begin(), byDegree.end() );
+                for( size_t i = 0; i < l.size(); i++ ) {
+                    l[i] = byDegree[i].second;
+                }
+            }
+            vector< pair<int, int> > byDegree;
+            for( size_t i = 0; i < starts.size(); i++ ) {
+                byDegree.push_back( make_pair( (int)links[starts[i]].size(), starts[i] ) );
+            }
+            sort( byDegree.begin(), byDegree.end() );
+            for( size_t i = 0; i < starts.size(); i++ ) {
+                starts[i] = byDegree[i].second;
+            }
+        }
+
+        vector<char> placed( maxNodes, 0 );
+        for( size_t s = 0; s < starts.size(); s++ ) {
+            if( placed[starts[s]] ) {
+                continue;
+            }
+            size_t front = m_external.size();
+            m_external.push_back( starts[s] );
+            placed[starts[s]] = 1;
+            for( ; front < m_external.size(); front++ ) {
+                vector<int> const & l = links[m_external[front]];
+                for( size_t i = 0; i < l.size(); i++ ) {
+                    if( !placed[l[i]] ) {
+                        placed[l[i]] = 1;
+                        m_external.push_back( l[i] );
+                    }
+                }
+            }
+        }
+        if( nodeOrder == ORDER_RCM ) {
+            reverse( m_external.begin(), m_external.end() );
+        }
+    }
+
+    // empty slots go on the end, so every index has an id. Left
+    // with no order, this keeps every index as it is.
+    bool reordered = !m_external.empty();
+    for( index = 0; index < maxNodes; index++ ) {
+        if( pNodes[index] == 0 || !reordered ) {
+            m_external.push_back( index );
+        }
+    }
+    m_internal.assign( maxNodes, 0 );
+    for( int id = 0; id < maxNodes; id++ ) {
+        m_internal[m_external[id]] = id;
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           build
+//  Description:    Packs the arcs of every node into the flat
+//                  arrays, keeping the order of each arc list.
+//  Arguments:      The first argument is the graph's node array.
+//                  The second argument is the size of that array.
+//                  The third argument maps each node to its index.
+//                  The fourth argument is how to number the nodes.
+//                  The fifth argument is the position of each node
+//                  by index, needed for ORDER_HILBERT.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void CompactGraph<NodeType, ArcType>::build( Node** pNodes, int maxNodes, unordered_map<Node*, int> const & indices,
+                                             NodeOrder nodeOrder, vector< pair<double, double> > const * pPositions ) {
+    int id;
+    order( pNodes, maxNodes, indices, nodeOrder, pPositions );
+    m_nodes.resize( maxNodes );
+    m_offsets.assign( maxNodes + 1, 0 );
+    m_inOffsets.assign( maxNodes + 1, 0 );
+    m_targets.clear();
+    m_weights.clear();
+    m_minWeight = ArcType();
+    m_maxWeight = ArcType();
+
+    // forward arcs, in packed id order and arc list order.
+    for( id = 0; id < maxNodes; id++ ) {
+        Node* pNode = pNodes[m_external[id]];
+        m_nodes[id] = pNode;
+        m_offsets[id] = (int)m_targets.size();
+        if( pNode != 0 ) {
+            typename list< GraphArc<NodeType, ArcType> >::const_iterator iter = pNode->arcList().begin();
+            typename list< GraphArc<NodeType, ArcType> >::const_iterator endIter = pNode->arcList().end();
+            for( ; iter != endIter; ++iter ) {
+                int to = m_internal[indices.find( (*iter).node() )->second];
+                m_targets.push_back( to );
+                if( m_weights.empty() || (*iter).weight() < m_minWeight ) {
+                    m_minWeight = (*iter).weight();
+                }
+                if( m_weights.empty() || (*iter).weight() > m_maxWeight ) {
+                    m_maxWeight = (*iter).weight();
+                }
+                m_weights.push_back( (*iter).weight() );
+                m_inOffsets[to + 1]++;
+            }
+        }
+    }
+    m_offsets[maxNodes] = (int)m_targets.size();
+
+    // reverse arcs, counted above and placed with a prefix sum.
+    for( id = 0; id < maxNodes; id++ ) {
+        m_inOffsets[id + 1] += m_inOffsets[id];
+    }
+    m_sources.resize( m_targets.size() );
+    m_inWeights.resize( m_targets.size() );
+    vector<int> fill( m_inOffsets.begin(), m_inOffsets.end() - 1 );
+    for( id = 0; id < maxNodes; id++ ) {
+        for( int arc = m_offsets[id]; arc < m_offsets[id + 1]; arc++ ) {
+            int slot = fill[m_targets[arc]]++;
+            m_sources[slot] = id;
+            m_inWeights[slot] = m_weights[arc];
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           insertArc
+//  Description:    Patches in one new arc, leaving the arrays as a
+//                  rebuild would: last among the arcs leaving its
+//                  start, and in start order among those arriving
+//                  at its end. The arrays and offsets behind the
+//                  slot are shifted, so an edit costs O(V + E): far
+//                  less than a rebuild's sort and copies, but still
+//                  linear, so bulk loads should build instead.
+//  Arguments:      The packed ids of the arc's start and end, and
+//                  its weight.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void CompactGraph<NodeType, ArcType>::insertArc( int from, int to, ArcType weight ) {
+    int id;
+    int slot = m_offsets[from + 1];
+    if( m_targets.empty() || weight < m_minWeight ) {
+        m_minWeight = weight;
+    }
+    if( m_targets.empty() || weight > m_maxWeight ) {
+        m_maxWeight = weight;
+    }
+    m_targets.insert( m_targets.begin() + slot, to );
+    m_weights.insert( m_weights.begin() + slot, weight );
+    for( id = from + 1; id < (int)m_offsets.size(); id++ ) {
+        m_offsets[id]++;
+    }
+
+    int inSlot = m_inOffsets[to];
+    while( inSlot != m_inOffsets[to + 1] && m_sources[inSlot] < from ) {
+        inSlot++;
+    }
+    m_sources.insert( m_sources.begin() + inSlot, from );
+    m_inWeights.insert( m_inWeights.begin() + inSlot, weight );
+    for( id = to + 1; id < (int)m_inOffsets.size(); id++ ) {
+        m_inOffsets[id]++;
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           eraseArc
+//  Description:    Patches out one arc, if it is there. Like
+//                  insertArc this shifts the arrays, at O(V + E).
+//                  The weight range is left as it was, so it stays
+//                  a bound but may be wider than a rebuild makes it.
+//  Arguments:      The packed ids of the arc's start and end.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void CompactGraph<NodeType, ArcType>::eraseArc( int from, int to ) {
+    int id;
+    int slot = m_offsets[from];
+    while( slot != m_offsets[from + 1] && m_targets[slot] != to ) {
+        slot++;
+    }
+    if( slot == m_offsets[from + 1] ) {
+        return;
+    }
+    m_targets.erase( m_targets.begin() + slot );
+    m_weights.erase( m_weights.begin() + slot );
+    for( id = from + 1; id < (int)m_offsets.size(); id++ ) {
+        m_offsets[id]--;
+    }
+
+    int inSlot = m_inOffsets[to];
+    while( m_sources[inSlot] != from ) {
+        inSlot++;
+    }
+    m_sources.erase( m_sources.begin() + inSlot );
+    m_inWeights.erase( m_inWeights.begin() + inSlot );
+    for( id = to + 1; id < (int)m_inOffsets.size(); id++ ) {
+        m_inOffsets[id]--;
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           setNode
+//  Description:    Patches the node behind an id, for a node added
+//                  to the graph or removed once its arcs are gone.
+//                  Ids keep their numbering, whatever the order.
+//  Arguments:      The packed id and the node, or 0 for none.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void CompactGraph<NodeType, ArcType>::setNode( int id, Node* pNode ) {
+    m_nodes[id] = pNode;
+}
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef COMPRESSEDGRAPH_H
+#define COMPRESSEDGRAPH_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#include "CompactGraph.h"
+#include "DisjointSet.h"
+
+// -------------------------------------------------------
+// Name:        ArcRecord
+// Description: One arc as read from an arc file, for
+//              building a CompressedGraph with no Graph.
+// -------------------------------------------------------
+template<class ArcType>
+struct ArcRecord {
+    int from;
+    int to;
+    ArcType weight;
+};
+
+// -------------------------------------------------------
+// Name:        CompressedGraph
+// Description: A read-only copy of the arcs of a graph,
+//              squeezed into one byte stream. Each node's
+//              arcs are sorted by target, and the targets
+//              are stored as gaps from the one before (the
+//              first as a signed gap from the node itself)
+//              in variable length bytes, after the length
+//              of the node's bytes. Weights are stored as
+//              steps above the lightest weight, so they
+//              must be whole numbers. It can be built from
+//              a CompactGraph, keeping its packed ids so a
+//              locality order keeps the gaps small, or
+//              straight from arcs read from a file or
+//              iterator, with node indices as ids.
+//              There is no per-node pointer or offset: a
+//              node is found from the start of its block of
+//              BLOCK nodes by skipping the lengths before
+//              it, and the graph nodes are left to the
+//              Graph searching it.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class CompressedGraph {
+    static_assert( is_integral<ArcType>::value, "CompressedGraph stores weights as whole steps, so ArcType must be integral" );
+
+private:
+    static const int BLOCK = 16;
+
+// -------------------------------------------------------
+// Description: Node i's length and arcs are found by
+//              starting at m_blocks[i / BLOCK] and skipping
+//              over the i % BLOCK nodes before it.
+// -------------------------------------------------------
+    vector<unsigned long long> m_blocks;
+    vector<unsigned char> m_bytes;
+    int m_size;
+
+// -------------------------------------------------------
+// Description: A weight is m_minWeight plus its stored
+//              value times m_step.
+// -------------------------------------------------------
+    ArcType m_minWeight;
+    ArcType m_maxWeight;
+    ArcType m_step;
+    int m_arcCount;
+
+// -------------------------------------------------------
+// Description: The id of each graph index and the index
+//              of each id, both empty when ids are indices.
+// -------------------------------------------------------
+    vector<int> m_internal;
+    vector<int> m_external;
+
+// -------------------------------------------------------
+// Description: The weakly connected component of each id,
+//              named by one id in it.
+// -------------------------------------------------------
+    vector<int> m_components;
+
+    static void writeVarint( vector<unsigned char>& bytes, unsigned long long value );
+    static unsigned long long readVarint( unsigned char const* & p );
+    void encode( int nodes, vector< ArcRecord<ArcType> >& arcs );
+
+public:
+    CompressedGraph() : m_size( 0 ), m_minWeight( 0 ), m_maxWeight( 0 ), m_step( 1 ), m_arcCount( 0 ) {
+    }
+
+    // Accessor functions
+    int size() const {
+        return m_size;
+    }
+
+    int arcCount() const {
+        return m_arcCount;
+    }
+
+    ArcType minWeight() const {
+        return m_minWeight;
+    }
+
+    ArcType maxWeight() const {
+        return m_maxWeight;
+    }
+
+    int internal( int index ) const {
+        return m_internal.empty() ? index : m_internal[index];
+    }
+
+    int external( int id ) const {
+        return m_external.empty() ? id : m_external[id];
+    }
+
+    int component( int id ) const {
+        return m_components[id];
+    }
+
+    unsigned long long memoryBytes() const;
+
+    template<class Func>
+    void forEachArc( int id, Func func ) const;
+
+    void build( CompactGraph<NodeType, ArcType> const & packed );
+    template<class Iterator>
+    void build( int nodes, Iterator first, Iterator last );
+    bool load( std::string const & arcFile, int nodes, bool dual = false );
+};
+
+// ----------------------------------------------------------------
+//  Name:           writeVarint
+//  Description:    Appends a number seven bits at a time, low bits
+//                  first, with the top bit set on all but the last.
+//  Arguments:      The bytes to append to, and the number.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void CompressedGraph<NodeType, ArcType>::writeVarint( vector<unsigned char>& bytes, unsigned long long value ) {
+    while( value >= 0x80 ) {
+        bytes.push_back( (unsigned char)( value | 0x80 ) );
+        value >>= 7;
+    }
+    bytes.push_back( (unsigned char)value );
+}
+
+// ----------------------------------------------------------------
+//  Name:           readVarint
+//  Description:    Reads a number written by writeVarint.
+//  Arguments:      The read position, moved past the number.
+//  Return Value:   The number.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+unsigned long long CompressedGraph<NodeType, ArcType>::readVarint( unsigned char const* & p ) {
+    unsigned long long value = *p & 0x7f;
+    int shift = 7;
+    while( *p++ & 0x80 ) {
+        value |= (unsigned long long)( *p & 0x7f ) << shift;
+        shift += 7;
+    }
+    return value;
+}
+
+// ----------------------------------------------------------------
+//  Name:           memoryBytes
+//  Description:    Adds up the memory the arrays use.
+//  Arguments:      None.
+//  Return Value:   The size in bytes.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+unsigned long long CompressedGraph<NodeType, ArcType>::memoryBytes() const {
+    return m_blocks.capacity() * sizeof( unsigned long long ) + m_bytes.capacity() +
+           ( m_internal.capacity() + m_external.capacity() + m_components.capacity() ) * sizeof( int );
+}
+
+// ----------------------------------------------------------------
+//  Name:           forEachArc
+//  Description:    Decodes the arcs leaving a node, in target order.
+//  Arguments:      The first argument is the node id.
+//                  The second argument is called with the target id
+//                  and weight of each arc.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Func>
+void CompressedGraph<NodeType, ArcType>::forEachArc( int id, Func func ) const {
+    unsigned char const* p = m_bytes.data() + m_blocks[id / BLOCK];
+    for( int skip = id % BLOCK; skip > 0; skip-- ) {
+        unsigned long long length = readVarint( p );
+        p += length;
+    }
+    unsigned long long length = readVarint( p );
+    unsigned char const* end = p + length;
+    if( p == end ) {
+        return;
+    }
+    // the first gap is zigzag coded, since it can go either way.
+    unsigned long long zigzag = readVarint( p );
+    long long target = id + ( ( zigzag & 1 ) ? -(long long)( zigzag >> 1 ) - 1 : (long long)( zigzag >> 1 ) );
+    func( (int)target, (ArcType)( m_minWeight + (ArcType)readVarint( p ) * m_step ) );
+    while( p != end ) {
+        target += (long long)readVarint( p );
+        func( (int)target, (ArcType)( m_minWeight + (ArcType)readVarint( p ) * m_step ) );
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           encode
+//  Description:    Writes the byte stream and components for a set
+//                  of arcs between ids. Where an arc is listed more
+//                  than once, the first listed is kept, as addArc
+//                  turns down the rest.
+//  Arguments:      The number of ids, and the arcs, which are
+//                  sorted in place.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void CompressedGraph<NodeType, ArcType>::encode( int nodes, vector< ArcRecord<ArcType> >& arcs ) {
+    size_t i;
+    stable_sort( arcs.begin(), arcs.end(), []( ArcRecord<ArcType> const & a, ArcRecord<ArcType> const & b ) {
+        return a.from != b.from ? a.from < b.from : a.to < b.to;
+    } );
+    size_t kept = 0;
+    for( i = 0; i < arcs.size(); i++ ) {
+        if( kept == 0 || arcs[i].from != arcs[kept - 1].from || arcs[i].to != arcs[kept - 1].to ) {
+            arcs[kept++] = arcs[i];
+        }
+    }
+    arcs.resize( kept );
+    m_size = nodes;
+    m_arcCount = (int)arcs.size();
+
+    // the weight step is the largest that divides every weight's
+    // distance from the lightest, which keeps them exact.
+    m_minWeight = 0;
+    m_maxWeight = 0;
+    m_step = 0;
+    for( i = 0; i < arcs.size(); i++ ) {
+        if( i == 0 || arcs[i].weight < m_minWeight ) {
+            m_minWeight = arcs[i].weight;
+        }
+        if( i == 0 || arcs[i].weight > m_maxWeight ) {
+            m_maxWeight = arcs[i].weight;
+        }
+    }
+    for( i = 0; i < arcs.size(); i++ ) {
+        long long a = (long long)( arcs[i].weight - m_minWeight );
+        long long b = (long long)m_step;
+        while( b != 0 ) {
+            long long t = a % b;
+            a = b;
+            b = t;
+        }
+        m_step = (ArcType)a;
+    }
+    if( m_step <= 0 ) {
+        m_step = 1;
+    }
+
+    m_blocks.assign( ( nodes + BLOCK - 1 ) / BLOCK, 0 );
+    m_bytes.clear();
+    vector<unsigned char> node;
+    DisjointSet components( nodes );
+    size_t next = 0;
+    for( int id = 0; id < nodes; id++ ) {
+        if( id % BLOCK == 0 ) {
+            m_blocks[id / BLOCK] = m_bytes.size();
+        }
+        node.clear();
+        long long last = id;
+        for( ; next < arcs.size() && arcs[next].from == id; next++ ) {
+            long long gap = arcs[next].to - last;
+            if( node.empty() ) {
+                writeVarint( node, gap < 0 ? ( (unsigned long long)( -gap - 1 ) << 1 ) | 1 : (unsigned long long)gap << 1 );
+            }
+            else {
+                writeVarint( node, (unsigned long long)gap );
+            }
+            writeVarint( node, (unsigned long long)( ( arcs[next].weight - m_minWeight ) / m_step ) );
+            last = arcs[next].to;
+            components.unite( id, arcs[next].to );
+        }
+        writeVarint( m_bytes, node.size() );
+        m_bytes.insert( m_bytes.end(), node.begin(), node.end() );
+    }
+    m_bytes.shrink_to_fit();
+
+    m_components.resize( nodes );
+    for( int id = 0; id < nodes; id++ ) {
+        m_components[id] = components.find( id );
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           build
+//  Description:    Encodes the arcs of a packed graph, keeping its
+//                  ids. Its order is only kept if it isn't the
+//                  index order.
+//  Arguments:      The packed graph to copy.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void CompressedGraph<NodeType, ArcType>::build( CompactGraph<NodeType, ArcType> const & packed ) {
+    int n = packed.size();
+    int id;
+    bool reordered = false;
+    for( id = 0; id < n && !reordered; id++ ) {
+        reordered = packed.external( id ) != id;
+    }
+    m_internal.clear();
+    m_external.clear();
+    if( reordered ) {
+        m_internal.resize( n );
+        m_external.resize( n );
+        for( id = 0; id < n; id++ ) {
+            m_external[id] = packed.external( id );
+            m_internal[packed.external( id )] = id;
+        }
+    }
+
+    vector< ArcRecord<ArcType> > arcs;
+    arcs.reserve( packed.arcCount() );
+    for( id = 0; id < n; id++ ) {
+        for( int arc = packed.firstArc( id ); arc != packed.endArc( id ); arc++ ) {
+            ArcRecord<ArcType> record = { id, packed.target( arc ), packed.weight( arc ) };
+            arcs.push_back( record );
+        }
+    }
+    encode( n, arcs );
+}
+
+// ----------------------------------------------------------------
+//  Name:           build
+//  Description:    Encodes arcs given as ArcRecords, with no Graph
+//                  behind them. Ids are the node indices.
+//  Arguments:      The number of nodes, and the range of arcs.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Iterator>
+void CompressedGraph<NodeType, ArcType>::build( int nodes, Iterator first, Iterator last ) {
+    vector< ArcRecord<ArcType> > arcs( first, last );
+    m_internal.clear();
+    m_external.clear();
+    encode( nodes, arcs );
+}
+
+// ----------------------------------------------------------------
+//  Name:           load
+//  Description:    Encodes the arcs in a file of "from to weight"
+//                  lines, the form main reads, without building a
+//                  Graph. Arcs with an end outside the nodes are
+//                  skipped.
+//  Arguments:      The first argument is the arc file.
+//                  The second argument is the number of nodes.
+//                  The third argument adds each arc both ways, as
+//                  addDualArc does.
+//  Return Value:   false if the file can't be read.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool CompressedGraph<NodeType, ArcType>::load( std::string const & arcFile, int nodes, bool dual ) {
+    std::ifstream myfile( arcFile.c_str() );
+    if( !myfile ) {
+        return false;
+    }
+    vector< ArcRecord<ArcType> > arcs;
+    ArcRecord<ArcType> record;
+    while( myfile >> record.from >> record.to >> record.weight ) {
+        if( record.from < 0 || record.from >= nodes || record.to < 0 || record.to >= nodes ) {
+            continue;
+        }
+        arcs.push_back( record );
+        if( dual ) {
+            ArcRecord<ArcType> back = { record.to, record.from, record.weight };
+            arcs.push_back( back );
+        }
+    }
+    m_internal.clear();
+    m_external.clear();
+    encode( nodes, arcs );
+    return true;
+}
+
+#endif
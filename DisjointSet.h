@@ -0,0 +1,112 @@
+#ifndef DISJOINTSET_H
+#define DISJOINTSET_H
+
+#include <vector>
+
+// -------------------------------------------------------
+// Name:        DisjointSet
+// Description: Union-find over the numbers 0 to size - 1.
+//              Sets are joined by size and paths are halved
+//              on the way up, so find is close to O(1).
+// -------------------------------------------------------
+class DisjointSet {
+private:
+
+// -------------------------------------------------------
+// Description: The parent of each element (itself for a
+//              root), and the size of each root's set.
+// -------------------------------------------------------
+    std::vector<int> m_parent;
+    std::vector<int> m_size;
+
+// -------------------------------------------------------
+// Description: The number of separate sets.
+// -------------------------------------------------------
+    int m_sets;
+
+public:
+    DisjointSet() : m_sets( 0 ) {
+    }
+
+    explicit DisjointSet( int size ) {
+        reset( size );
+    }
+
+    // Accessor functions
+    int size() const {
+        return (int)m_parent.size();
+    }
+
+    int sets() const {
+        return m_sets;
+    }
+
+    // Manipulator functions
+    void reset( int size );
+    int find( int element );
+    bool unite( int a, int b );
+
+    bool same( int a, int b ) {
+        return find( a ) == find( b );
+    }
+
+    int setSize( int element ) {
+        return m_size[find( element )];
+    }
+};
+
+// ----------------------------------------------------------------
+//  Name:           reset
+//  Description:    Puts every element in a set of its own.
+//  Arguments:      The number of elements.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void DisjointSet::reset( int size ) {
+    m_parent.resize( size );
+    m_size.assign( size, 1 );
+    for( int i = 0; i < size; i++ ) {
+        m_parent[i] = i;
+    }
+    m_sets = size;
+}
+
+// ----------------------------------------------------------------
+//  Name:           find
+//  Description:    Finds the root of an element's set, pointing
+//                  each element passed at its grandparent.
+//  Arguments:      The element.
+//  Return Value:   The root element.
+// ----------------------------------------------------------------
+inline int DisjointSet::find( int element ) {
+    while( m_parent[element] != element ) {
+        m_parent[element] = m_parent[m_parent[element]];
+        element = m_parent[element];
+    }
+    return element;
+}
+
+// ----------------------------------------------------------------
+//  Name:           unite
+//  Description:    Joins the sets of two elements, hanging the
+//                  smaller under the larger.
+//  Arguments:      The two elements.
+//  Return Value:   true if they were in different sets.
+// ----------------------------------------------------------------
+inline bool DisjointSet::unite( int a, int b ) {
+    a = find( a );
+    b = find( b );
+    if( a == b ) {
+        return false;
+    }
+    if( m_size[a] < m_size[b] ) {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    m_parent[b] = a;
+    m_size[a] += m_size[b];
+    m_sets--;
+    return true;
+}
+
+#endif
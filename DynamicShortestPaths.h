@@ -0,0 +1,305 @@
+#ifndef DYNAMICSHORTESTPATHS_H
+#define DYNAMICSHORTESTPATHS_H
+
+#include <vector>
+#include <queue>
+#include <utility>
+#include <climits>
+
+#include "Graph.h"
+#include "GraphListener.h"
+
+// -------------------------------------------------------
+// Name:        DynamicShortestPaths
+// Description: Keeps shortest path trees from a set of
+//              sources up to date as arcs are added to and
+//              removed from a graph. Only the part of each
+//              tree an arc change affects is repaired
+//              (Ramalingam-Reps): an added arc spreads any
+//              improvement outwards from its end, and a
+//              removed tree arc resets the subtree below it
+//              and rebuilds it from the nodes around it.
+//              The arcs are read from the graph's packed
+//              copy, which the graph patches before telling
+//              its listeners, so no second copy is kept.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class DynamicShortestPaths : public GraphListener<NodeType, ArcType> {
+private:
+    typedef pair<int, int> Entry;
+
+// -------------------------------------------------------
+// Description: The graph being followed.
+// -------------------------------------------------------
+    Graph<NodeType, ArcType>& m_graph;
+
+// -------------------------------------------------------
+// Description: The source node indices, and for each one
+//              the cost to and previous index of every
+//              node (INT_MAX and -1 when unreachable).
+// -------------------------------------------------------
+    vector<int> m_sources;
+    vector< vector<int> > m_cost;
+    vector< vector<int> > m_prev;
+
+// -------------------------------------------------------
+// Description: (source number, target index) pairs whose
+//              cost changed since clearChanges, each listed
+//              once, and flags for the pairs already listed.
+// -------------------------------------------------------
+    vector< pair<int, int> > m_changes;
+    vector< vector<char> > m_reported;
+
+// -------------------------------------------------------
+// Description: Scratch space for repairs.
+// -------------------------------------------------------
+    vector<char> m_affected;
+    vector<int> m_oldCost;
+
+    void spread( int s, priority_queue< Entry, vector<Entry>, greater<Entry> >& pq );
+    void recordChange( int s, int node );
+
+public:
+    DynamicShortestPaths( Graph<NodeType, ArcType>& graph, vector<int> const & sources = vector<int>() );
+    ~DynamicShortestPaths();
+
+    // the graph holds this object's address as a listener, so a
+    // copy would never hear of an edit and would unhook the original.
+    DynamicShortestPaths( DynamicShortestPaths const & ) = delete;
+    DynamicShortestPaths& operator=( DynamicShortestPaths const & ) = delete;
+
+    // Accessor functions
+    int sourceCount() const {
+        return (int)m_sources.size();
+    }
+
+    int source( int s ) const {
+        return m_sources[s];
+    }
+
+    int cost( int s, int target ) const {
+        return m_cost[s][target];
+    }
+
+    int previous( int s, int target ) const {
+        return m_prev[s][target];
+    }
+
+    vector< pair<int, int> > const & changes() const {
+        return m_changes;
+    }
+
+    void clearChanges();
+    void arcAdded( int from, int to, ArcType weight );
+    void arcRemoved( int from, int to, ArcType weight );
+};
+
+// ----------------------------------------------------------------
+//  Name:           DynamicShortestPaths
+//  Description:    Solves every source from scratch and starts
+//                  listening to the graph.
+//  Arguments:      The first argument is the graph to follow.
+//                  The second argument lists the source node indices;
+//                  empty means every node (all pairs).
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+DynamicShortestPaths<NodeType, ArcType>::DynamicShortestPaths( Graph<NodeType, ArcType>& graph, vector<int> const & sources )
+    : m_graph( graph ), m_sources( sources ) {
+    CompactGraph<NodeType, ArcType> const & packed = graph.compact();
+    int n = packed.size();
+    int id;
+
+    if( m_sources.empty() ) {
+        for( id = 0; id < n; id++ ) {
+            if( packed.node( packed.internal( id ) ) != 0 ) {
+                m_sources.push_back( id );
+            }
+        }
+    }
+
+    m_cost.assign( m_sources.size(), vector<int>( n, INT_MAX ) );
+    m_prev.assign( m_sources.size(), vector<int>( n, -1 ) );
+    m_affected.assign( n, 0 );
+    m_reported.assign( m_sources.size(), vector<char>( n, 0 ) );
+    m_oldCost.assign( n, INT_MAX );
+
+    // a full search per source is just a spread from the source.
+    for( size_t s = 0; s < m_sources.size(); s++ ) {
+        priority_queue< Entry, vector<Entry>, greater<Entry> > pq;
+        m_cost[s][m_sources[s]] = 0;
+        pq.push( Entry( 0, m_sources[s] ) );
+        spread( (int)s, pq );
+    }
+    // the first solve isn't a change.
+    clearChanges();
+
+    m_graph.addListener( this );
+}
+
+template<class NodeType, class ArcType>
+DynamicShortestPaths<NodeType, ArcType>::~DynamicShortestPaths() {
+    m_graph.removeListener( this );
+}
+
+// ----------------------------------------------------------------
+//  Name:           spread
+//  Description:    Dijkstra from the queued nodes outwards, lowering
+//                  any cost it can. Nodes that end up cheaper are
+//                  recorded as changes. Costs are kept by node index,
+//                  since that is what the listener hears, and arcs
+//                  are looked up by packed id.
+//  Arguments:      The first argument is the source number.
+//                  The second argument holds (cost, node) entries to
+//                  start from.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void DynamicShortestPaths<NodeType, ArcType>::spread( int s, priority_queue< Entry, vector<Entry>, greater<Entry> >& pq ) {
+    vector<int>& cost = m_cost[s];
+    vector<int>& prev = m_prev[s];
+    CompactGraph<NodeType, ArcType> const & packed = m_graph.compact();
+    while( !pq.empty() ) {
+        Entry top = pq.top();
+        pq.pop();
+        // skip entries that have been beaten since they were queued.
+        if( top.first != cost[top.second] ) {
+            continue;
+        }
+        int id = packed.internal( top.second );
+        for( int arc = packed.firstArc( id ); arc != packed.endArc( id ); arc++ ) {
+            int c = top.first + packed.weight( arc );
+            int v = packed.external( packed.target( arc ) );
+            if( c < cost[v] ) {
+                // nodes reset by a removal are compared afterwards.
+                if( !m_affected[v] ) {
+                    recordChange( s, v );
+                }
+                cost[v] = c;
+                prev[v] = top.second;
+                pq.push( Entry( c, v ) );
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           recordChange
+//  Description:    Notes that a cost has changed, unless it already
+//                  has been since the last clearChanges.
+//  Arguments:      The source number and the node index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void DynamicShortestPaths<NodeType, ArcType>::recordChange( int s, int node ) {
+    if( !m_reported[s][node] ) {
+        m_reported[s][node] = 1;
+        m_changes.push_back( pair<int, int>( s, node ) );
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           clearChanges
+//  Description:    Empties the list of changed costs.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void DynamicShortestPaths<NodeType, ArcType>::clearChanges() {
+    for( size_t i = 0; i < m_changes.size(); i++ ) {
+        m_reported[m_changes[i].first][m_changes[i].second] = 0;
+    }
+    m_changes.clear();
+}
+
+// ----------------------------------------------------------------
+//  Name:           arcAdded
+//  Description:    A new arc can only make paths cheaper, and only
+//                  through its far end, so each tree is repaired by
+//                  spreading from there when the arc helps.
+//  Arguments:      The arc's start and end indices, and weight.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void DynamicShortestPaths<NodeType, ArcType>::arcAdded( int from, int to, ArcType weight ) {
+    for( size_t s = 0; s < m_sources.size(); s++ ) {
+        vector<int>& cost = m_cost[s];
+        if( cost[from] != INT_MAX && cost[from] + weight < cost[to] ) {
+            priority_queue< Entry, vector<Entry>, greater<Entry> > pq;
+            recordChange( (int)s, to );
+            cost[to] = cost[from] + weight;
+            m_prev[s][to] = from;
+            pq.push( Entry( cost[to], to ) );
+            spread( (int)s, pq );
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           arcRemoved
+//  Description:    Only trees that used the arc are affected. In
+//                  those, the subtree below the arc is reset, each
+//                  of its nodes takes the best offer from outside
+//                  the subtree, and the costs are spread inside it.
+//  Arguments:      The arc's start and end indices, and weight.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void DynamicShortestPaths<NodeType, ArcType>::arcRemoved( int from, int to, ArcType weight ) {
+    CompactGraph<NodeType, ArcType> const & packed = m_graph.compact();
+    for( size_t s = 0; s < m_sources.size(); s++ ) {
+        vector<int>& cost = m_cost[s];
+        vector<int>& prev = m_prev[s];
+        if( prev[to] != from ) {
+            continue;
+        }
+
+        // collect the subtree hanging from the removed arc.
+        vector<int> subtree;
+        subtree.push_back( to );
+        m_affected[to] = 1;
+        for( size_t i = 0; i < subtree.size(); i++ ) {
+            int id = packed.internal( subtree[i] );
+            for( int arc = packed.firstArc( id ); arc != packed.endArc( id ); arc++ ) {
+                int v = packed.external( packed.target( arc ) );
+                if( !m_affected[v] && prev[v] == subtree[i] ) {
+                    m_affected[v] = 1;
+                    subtree.push_back( v );
+                }
+            }
+        }
+        for( size_t i = 0; i < subtree.size(); i++ ) {
+            m_oldCost[subtree[i]] = cost[subtree[i]];
+            cost[subtree[i]] = INT_MAX;
+            prev[subtree[i]] = -1;
+        }
+
+        // best way into each subtree node from the unaffected part.
+        priority_queue< Entry, vector<Entry>, greater<Entry> > pq;
+        for( size_t i = 0; i < subtree.size(); i++ ) {
+            int v = subtree[i];
+            int id = packed.internal( v );
+            for( int inArc = packed.firstInArc( id ); inArc != packed.endInArc( id ); inArc++ ) {
+                int u = packed.external( packed.source( inArc ) );
+                if( !m_affected[u] && cost[u] != INT_MAX && cost[u] + packed.inWeight( inArc ) < cost[v] ) {
+                    cost[v] = cost[u] + packed.inWeight( inArc );
+                    prev[v] = u;
+                }
+            }
+            if( cost[v] != INT_MAX ) {
+                pq.push( Entry( cost[v], v ) );
+            }
+        }
+        spread( (int)s, pq );
+
+        for( size_t i = 0; i < subtree.size(); i++ ) {
+            int v = subtree[i];
+            m_affected[v] = 0;
+            if( cost[v] != m_oldCost[v] ) {
+                recordChange( (int)s, v );
+            }
+        }
+    }
+}
+
+#endif
@@ -3,11 +3,88 @@
 
 #include <list>
 #include <queue>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+
+#include "BitSet.h"
+#include "BucketQueue.h"
+#include "DisjointSet.h"
+#include "Barrier.h"
+#include "GraphListener.h"
+#include "NodeOrder.h"
+#include "MemoryStats.h"
+#include "SearchStats.h"
+#include "PathResult.h"
 
 using namespace std;
 
 template <class NodeType, class ArcType> class GraphArc;
 template <class NodeType, class ArcType> class GraphNode;
+template <class NodeType, class ArcType> class CompactGraph;
+template <class NodeType, class ArcType> class CompressedGraph;
+template <class NodeType, class ArcType> class GraphSnapshot;
+template <class NodeType, class ArcType> class BreadthFirstRange;
+template <class NodeType, class ArcType> class DepthFirstRange;
+
+// ----------------------------------------------------------------
+//  Name:           VisitResult
+//  Description:    What a traversal's visitor can return to steer
+//                  it. Visitors that return nothing always continue.
+// ----------------------------------------------------------------
+enum VisitResult {
+    VISIT_CONTINUE,     // carry on as normal
+    VISIT_PRUNE,        // don't follow this node's arcs
+    VISIT_STOP          // end the traversal now
+};
+
+// ----------------------------------------------------------------
+//  Name:           SearchQueue
+//  Description:    The priority queue UCS keeps its frontier in.
+// ----------------------------------------------------------------
+enum SearchQueue {
+    QUEUE_HEAP,         // binary heap, for any weights
+    QUEUE_BUCKET        // Dial's buckets or a radix heap, for whole
+                        // non-negative weights; others use the heap
+};
+
+// ----------------------------------------------------------------
+//  Name:           NoVisit
+//  Description:    A visitor that does nothing, for traversals that
+//                  only want the marks or other side effects.
+// ----------------------------------------------------------------
+struct NoVisit {
+    template<class NodePtr>
+    void operator()(NodePtr) const {
+    }
+};
+
+// ----------------------------------------------------------------
+//  Name:           callVisitor
+//  Description:    Calls a visitor (function, lambda or functor) on a
+//                  node and turns its return value into a VisitResult.
+//  Arguments:      The visitor, and the node to visit.
+//  Return Value:   What the traversal should do next.
+// ----------------------------------------------------------------
+template<class Visitor, class NodePtr>
+inline VisitResult callVisitor(Visitor& visit, NodePtr pNode, true_type) {
+    visit(pNode);
+    return VISIT_CONTINUE;
+}
+
+template<class Visitor, class NodePtr>
+inline VisitResult callVisitor(Visitor& visit, NodePtr pNode, false_type) {
+    return visit(pNode);
+}
+
+template<class Visitor, class NodePtr>
+inline VisitResult callVisitor(Visitor& visit, NodePtr pNode) {
+    return callVisitor(visit, pNode, typename is_void<decltype(visit(pNode))>::type());
+}
 
 // ----------------------------------------------------------------
 //  Name:           Graph
@@ -38,6 +115,149 @@ private:
 // ----------------------------------------------------------------
     int m_count;
 
+// ----------------------------------------------------------------
+//  Description:    Maps every node back to its index in m_pNodes,
+//                  so per-node arrays can be filled during searches.
+// ----------------------------------------------------------------
+    unordered_map<Node*, int> m_indices;
+
+// ----------------------------------------------------------------
+//  Description:    Bumped by every change to the nodes or arcs.
+// ----------------------------------------------------------------
+    unsigned int m_version;
+
+// ----------------------------------------------------------------
+//  Description:    Packed copy of the arcs. Node and arc edits made
+//                  while it is up to date patch it in place; it is
+//                  only rebuilt, on demand, when it is older than
+//                  m_version. While a snapshot or a traversal range
+//                  shares it, it is never changed again: the next
+//                  edit patches a copy, or a rebuild starts a new one.
+// ----------------------------------------------------------------
+    shared_ptr< CompactGraph<NodeType, ArcType> > m_pCompact;
+    unsigned int m_compactVersion;
+
+// ----------------------------------------------------------------
+//  Description:    Set once the packed copy has been handed out, and
+//                  cleared when it is replaced. The share count can't
+//                  stand in for it: a reader on another thread lets go
+//                  with a relaxed decrement, so a count of one doesn't
+//                  mean its reads are over.
+// ----------------------------------------------------------------
+    bool m_compactShared;
+
+    bool patchable();
+
+// ----------------------------------------------------------------
+//  Description:    How the packed copy numbers the nodes, and the
+//                  node positions by index for ORDER_HILBERT.
+// ----------------------------------------------------------------
+    NodeOrder m_order;
+    vector< pair<double, double> > m_positions;
+
+// ----------------------------------------------------------------
+//  Description:    Weakly connected components by node index, joined
+//                  as arcs are added. A removal that could split a
+//                  component, which union-find can't undo, marks them
+//                  stale and the next lookup rebuilds them all from
+//                  the arc lists, O(V + E). Removals that can't split
+//                  one leave them be: an arc whose reverse is still
+//                  there, or a node with at most one neighbour. The
+//                  slot of a removed node may still look joined to
+//                  its old component, which at worst costs a search.
+// ----------------------------------------------------------------
+    DisjointSet m_components;
+    bool m_componentsStale;
+
+// ----------------------------------------------------------------
+//  Description:    Strongly connected component of each node index,
+//                  numbered in topological order, and the version
+//                  they were worked out for.
+// ----------------------------------------------------------------
+    vector<int> m_strong;
+    unsigned int m_strongVersion;
+
+// ----------------------------------------------------------------
+//  Description:    Topological order of the node indices (empty if
+//                  the graph has a cycle), the place of each index
+//                  in it, and the version it was worked out for.
+// ----------------------------------------------------------------
+    vector<int> m_topoOrder;
+    vector<int> m_topoPosition;
+    unsigned int m_topoVersion;
+
+// ----------------------------------------------------------------
+//  Description:    The queue UCS uses, and the heaviest weight it
+//                  gives Dial's buckets before using a radix heap.
+// ----------------------------------------------------------------
+    SearchQueue m_searchQueue;
+
+// ----------------------------------------------------------------
+//  Description:    Where searches count their work, or 0 for nowhere.
+// ----------------------------------------------------------------
+    SearchStats* m_pStats;
+
+// ----------------------------------------------------------------
+//  Description:    The snapshot readers get from snapshot(), only
+//                  ever read or replaced atomically. Empty until the
+//                  first publish.
+// ----------------------------------------------------------------
+    shared_ptr< GraphSnapshot<NodeType, ArcType> const > m_pPublished;
+
+    static const int DIAL_LIMIT = 1 << 16;
+
+    int packedId( Node* pNode ) const;
+    // whether an index is in range and holds a node.
+    bool present( int index ) const {
+        return index >= 0 && index < m_maxNodes && m_pNodes[index] != 0;
+    }
+    void unpack( vector<int>& values, bool ids ) const;
+
+// ----------------------------------------------------------------
+//  Description:    Everything to tell when an arc is added or removed.
+// ----------------------------------------------------------------
+    vector<GraphListener<NodeType, ArcType>*> m_listeners;
+
+    void notifyAdded( int from, int to, ArcType weight );
+    void notifyRemoved( int from, int to, ArcType weight );
+
+// ----------------------------------------------------------------
+//  Description:    The hot per-node search state, kept out of the
+//                  nodes in dense arrays by node index: cost, previous
+//                  index and a visited bit. The nodes the last search
+//                  touched are listed so only those need resetting.
+//                  searchPath says what, if anything, goes back into
+//                  the nodes afterwards.
+// ----------------------------------------------------------------
+    vector<int> m_searchCost;
+    vector<int> m_searchPrev;
+    BitSet m_searchVisited;
+    vector<int> m_touched;
+
+    void resetSearch();
+    void touch( int id, int cost, int prev );
+    void markVisited( int id, int prev );
+    template<class Arcs>
+    void searchPath( Arcs const & arcs, int target, std::vector<Node*>& path );
+    template<class Arcs>
+    void searchPath( Arcs const & arcs, int target, PathResult& result );
+    static void startPath( std::vector<Node*>& ) {
+    }
+    static void startPath( PathResult& result ) {
+       result.clear();
+    }
+    // the graph node behind an id of packed or compressed arcs.
+    template<class Arcs>
+    Node* nodeOf( Arcs const & arcs, int id ) const {
+       return m_pNodes[arcs.external( id )];
+    }
+    template<class Arcs, class Visitor>
+    void breadthFirstOver( Arcs const & arcs, Node* pNode, Visitor visit );
+    template<class Arcs, class Visitor, class Path>
+    void UCSQueued( Arcs const & arcs, Node* pStart, Node* pTarget, Visitor visit, Path& path );
+    template<class Arcs, class Queue, class Visitor, class Path>
+    void UCSOver( Arcs const & arcs, Queue& pq, Node* pStart, Node* pTarget, Visitor visit, Path& path );
+
 
 public:           
     // Constructor and destructor functions
@@ -49,6 +269,36 @@ public:
        return m_pNodes;
     }
 
+    int maxNodes() const {
+       return m_maxNodes;
+    }
+
+    int count() const {
+       return m_count;
+    }
+
+    unsigned int version() const {
+       return m_version;
+    }
+
+    int indexOf( Node* pNode ) const;
+    MemoryStats memoryStats() const;
+    CompactGraph<NodeType, ArcType> const & compact();
+    int component( int index );
+    bool connected( int from, int to );
+    bool mayReach( int from, int to );
+    void setSearchQueue( SearchQueue queue ) {
+       m_searchQueue = queue;
+    }
+    void setSearchStats( SearchStats* pStats ) {
+       m_pStats = pStats;
+    }
+    void setOrder( NodeOrder nodeOrder, vector< pair<double, double> > const & positions = vector< pair<double, double> >() );
+    void addListener( GraphListener<NodeType, ArcType>* pListener );
+    void removeListener( GraphListener<NodeType, ArcType>* pListener );
+    void publish();
+    shared_ptr< GraphSnapshot<NodeType, ArcType> const > snapshot() const;
+
     // Public member functions.
     bool addNode( NodeType data, int index );
     void removeNode( int index );
@@ -58,10 +308,36 @@ public:
     Arc* getArc( int from, int to );
 	void prepUCS();
     void clearMarks();
-    void depthFirst( Node* pNode, void (*pProcess)(Node*) );
-	void breadthFirst(Node* pNode, void(*pProcess)(Node*));
-	void breadthFirstPlus(Node* pNode, Node* pTarget, void(*pProcess)(Node*));
-	void UCS(Node* pStart, Node* pTarget, void(*pProcess)(Node*), std::vector<Node*>& path);
+    template<class Visitor>
+    void depthFirst( Node* pNode, Visitor visit );
+    template<class Visitor, class PostVisitor>
+    void depthFirst( Node* pNode, Visitor visit, PostVisitor postVisit,
+                     vector<int>* pDiscovery = 0, vector<int>* pFinish = 0 );
+	template<class Visitor>
+	void breadthFirst(Node* pNode, Visitor visit);
+	template<class Visitor>
+	void breadthFirst(CompressedGraph<NodeType, ArcType> const & arcs, Node* pNode, Visitor visit);
+	template<class Visitor>
+	void breadthFirstPlus(Node* pNode, Node* pTarget, Visitor visit);
+	void breadthFirstHybrid(Node* pNode, vector<int>& parent, vector<int>& level);
+	void breadthFirstParallel(Node* pNode, vector<int>& parent, vector<int>& level, int threads = 0);
+	void breadthFirstMultiSource(vector<Node*> const & sources, vector< vector<int> >& hops);
+	BreadthFirstRange<NodeType, ArcType> bfsRange(Node* pStart);
+	DepthFirstRange<NodeType, ArcType> dfsRange(Node* pStart);
+	template<class Visitor, class Path>
+	void UCS(Node* pStart, Node* pTarget, Visitor visit, Path& path);
+	template<class Visitor, class Path>
+	void UCS(CompressedGraph<NodeType, ArcType> const & arcs, Node* pStart, Node* pTarget, Visitor visit, Path& path);
+	void deltaStepping(Node* pStart, vector<int>& dist, vector<int>& prev, ArcType delta = 0, int threads = 0);
+	void tracePath(Node* pTarget, std::vector<Node*>& path);
+	void UCSMany(Node* pStart, vector<Node*> const & targets, vector< vector<Node*> >& paths, vector<int>& costs);
+	void UCSRange(Node* pStart, int budget, vector< pair<Node*, int> >& reached);
+	int strongComponents(vector<int>& component, vector< vector<int> >* pDag = 0);
+	ArcType minimumSpanningForest(vector< pair<int, int> >& arcs, int threads = 0);
+	ArcType minimumSpanningForestKruskal(vector< pair<int, int> >& arcs);
+	bool topologicalOrder(vector<int>& order);
+	template<class Path>
+	void shortestPath(Node* pStart, Node* pTarget, Path& path);
 
 };
 
@@ -92,6 +368,21 @@ Graph<NodeType, ArcType>::Graph( int size ) : m_maxNodes( size ) {
 
    // set the node count to 0.
    m_count = 0;
+
+   // nothing has been packed yet.
+   m_version = 1;
+   m_pCompact.reset( new CompactGraph<NodeType, ArcType>() );
+   m_compactVersion = 0;
+   m_compactShared = false;
+   m_order = ORDER_INDEX;
+
+   // every index starts in a component of its own.
+   m_components.reset( m_maxNodes );
+   m_componentsStale = false;
+   m_strongVersion = 0;
+   m_topoVersion = 0;
+   m_searchQueue = QUEUE_HEAP;
+   m_pStats = 0;
 }
 
 // ----------------------------------------------------------------
@@ -123,15 +414,27 @@ template<class NodeType, class ArcType>
 bool Graph<NodeType, ArcType>::addNode( NodeType data, int index ) {
    bool nodeNotPresent = false;
    // find out if a node does not exist at that index.
-   if ( m_pNodes[index] == 0) {
+   if ( index >= 0 && index < m_maxNodes && m_pNodes[index] == 0) {
       nodeNotPresent = true;
+      // a node removed from this slot may have left it joined to
+      // its old neighbours, which the new node is not.
+      if( m_components.setSize( index ) > 1 ) {
+          m_componentsStale = true;
+      }
       // create a new node, put the data in it, and unmark it.
+      bool patch = patchable();
       m_pNodes[index] = new Node;
       m_pNodes[index]->setData(data);
       m_pNodes[index]->setMarked(false);
+      m_indices[m_pNodes[index]] = index;
 
       // increase the count and return success.
       m_count++;
+      m_version++;
+      if( patch ) {
+          m_pCompact->setNode( m_pCompact->internal( index ), m_pNodes[index] );
+          m_compactVersion = m_version;
+      }
     }
         
     return nodeNotPresent;
@@ -146,14 +449,20 @@ bool Graph<NodeType, ArcType>::addNode( NodeType data, int index ) {
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::removeNode( int index ) {
      // Only proceed if node does exist.
-     if( m_pNodes[index] != 0 ) {
+     if( present( index ) ) {
          // now find every arc that points to the node that
          // is being removed and remove it.
          int node;
          Arc* arc;
+         // a node with one neighbour at most can't be holding two
+         // parts of its component together.
+         bool stale = m_componentsStale;
+         int neighbour = -1;
+         bool splits = false;
 
          // loop through every node
          for( node = 0; node < m_maxNodes; node++ ) {
+              arc = 0;
               // if the node is valid...
               if( m_pNodes[node] != 0 ) {
                   // see if the node has an arc pointing to the current node.
@@ -163,15 +472,41 @@ void Graph<NodeType, ArcType>::removeNode( int index ) {
               // remove the arc.
               if( arc != 0 ) {
                   removeArc( node, index );
+                  if( node != index ) {
+                      splits = splits || ( neighbour != -1 && neighbour != node );
+                      neighbour = node;
+                  }
+              }
+         }
+
+         // patch out the arcs leaving the node too, and tell the
+         // listeners about each once it is gone.
+         bool patch = patchable();
+         typename list<Arc>::const_iterator iter = m_pNodes[index]->arcList().begin();
+         typename list<Arc>::const_iterator endIter = m_pNodes[index]->arcList().end();
+         for( ; iter != endIter; ++iter ) {
+              int to = indexOf( (*iter).node() );
+              splits = splits || ( neighbour != -1 && neighbour != to );
+              neighbour = to;
+              if( patch ) {
+                  m_pCompact->eraseArc( m_pCompact->internal( index ), m_pCompact->internal( to ) );
               }
+              notifyRemoved( index, to, (*iter).weight() );
          }
         
 
         // now that every arc pointing to the current node has been removed,
         // the node can be deleted.
+        m_indices.erase( m_pNodes[index] );
         delete m_pNodes[index];
         m_pNodes[index] = 0;
         m_count--;
+        m_version++;
+        if( patch ) {
+            m_pCompact->setNode( m_pCompact->internal( index ), 0 );
+            m_compactVersion = m_version;
+        }
+        m_componentsStale = stale || splits;
     }
 }
 
@@ -188,8 +523,8 @@ template<class NodeType, class ArcType>
 bool Graph<NodeType, ArcType>::addArc( int from, int to, ArcType weight ) {
      bool proceed = true; 
      // make sure both nodes exist.
-     if( m_pNodes[from] == 0 || m_pNodes[to] == 0 ) {
-         proceed = false;
+     if( !present( from ) || !present( to ) ) {
+         return false;
      }
         
      // if an arc already exists we should not proceed
@@ -199,7 +534,15 @@ bool Graph<NodeType, ArcType>::addArc( int from, int to, ArcType weight ) {
 
      if (proceed == true) {
         // add the arc to the "from" node.
+        bool patch = patchable();
         m_pNodes[from]->addArc( m_pNodes[to], weight );
+        m_version++;
+        if( patch ) {
+            m_pCompact->insertArc( m_pCompact->internal( from ), m_pCompact->internal( to ), weight );
+            m_compactVersion = m_version;
+        }
+        m_components.unite( from, to );
+        notifyAdded( from, to, weight );
 		cout << "Adding arc from " << m_pNodes[from]->data().first << " to " << m_pNodes[to]->data().first << " weight " << weight << endl;
      }
         
@@ -210,19 +553,29 @@ template<class NodeType, class ArcType>
 bool Graph<NodeType, ArcType>::addDualArc(int from, int to, ArcType weight) {
 	bool proceed = true;
 	// make sure both nodes exist.
-	if (m_pNodes[from] == 0 || m_pNodes[to] == 0) {
-		proceed = false;
+	if (!present(from) || !present(to)) {
+		return false;
 	}
 
-	// if an arc already exists we should not proceed
-	if (m_pNodes[from]->getArc(m_pNodes[to]) != 0) {
+	// if an arc already exists either way we should not proceed
+	if (m_pNodes[from]->getArc(m_pNodes[to]) != 0 || m_pNodes[to]->getArc(m_pNodes[from]) != 0) {
 		proceed = false;
 	}
 
 	if (proceed == true) {
 		// add the arc to the "from" node.
+		bool patch = patchable();
 		m_pNodes[from]->addArc(m_pNodes[to], weight);
 		m_pNodes[to]->addArc(m_pNodes[from], weight);
+		m_version++;
+		if (patch) {
+			m_pCompact->insertArc(m_pCompact->internal(from), m_pCompact->internal(to), weight);
+			m_pCompact->insertArc(m_pCompact->internal(to), m_pCompact->internal(from), weight);
+			m_compactVersion = m_version;
+		}
+		m_components.unite(from, to);
+		notifyAdded(from, to, weight);
+		notifyAdded(to, from, weight);
 		//cout << "Adding dual arc from " << m_pNodes[from]->data().first << " to " << m_pNodes[to]->data().first << " weight " << weight << endl;
 	}
 
@@ -241,13 +594,136 @@ void Graph<NodeType, ArcType>::removeArc( int from, int to ) {
      // Make sure that the node exists before trying to remove
      // an arc from it.
      bool nodeExists = true;
-     if( m_pNodes[from] == 0 || m_pNodes[to] == 0 ) {
+     if( !present( from ) || !present( to ) ) {
          nodeExists = false;
      }
 
      if (nodeExists == true) {
-        // remove the arc.
-        m_pNodes[from]->removeArc( m_pNodes[to] );
+        // remember the weight for the listeners before it goes.
+        Arc* pArc = m_pNodes[from]->getArc( m_pNodes[to] );
+        if( pArc != 0 ) {
+            ArcType weight = pArc->weight();
+            // remove the arc.
+            bool patch = patchable();
+            m_pNodes[from]->removeArc( m_pNodes[to] );
+            m_version++;
+            if( patch ) {
+                m_pCompact->eraseArc( m_pCompact->internal( from ), m_pCompact->internal( to ) );
+                m_compactVersion = m_version;
+            }
+            // the ends stay joined if the arc back is still there.
+            if( m_pNodes[to]->getArc( m_pNodes[from] ) == 0 ) {
+                m_componentsStale = true;
+            }
+            notifyRemoved( from, to, weight );
+        }
+     }
+}
+
+// ----------------------------------------------------------------
+//  Name:           patchable
+//  Description:    Says whether an edit about to be made can patch
+//                  the packed arcs rather than leave them to be
+//                  rebuilt, which it can while they are up to date.
+//                  Listeners read the packed arcs as they hear about
+//                  edits, so while there are any they are brought up
+//                  to date first. Packed arcs a snapshot shares are
+//                  copied before they are patched.
+//  Arguments:      None.
+//  Return Value:   true if the edit should patch the packed arcs.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::patchable() {
+     if( !m_listeners.empty() ) {
+         compact();
+     }
+     if( m_compactVersion != m_version ) {
+         return false;
+     }
+     if( m_compactShared ) {
+         m_pCompact.reset( new CompactGraph<NodeType, ArcType>( *m_pCompact ) );
+         m_compactShared = false;
+     }
+     return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           publish
+//  Description:    Makes the graph as it is now what readers see.
+//                  Edits made since the last publish go out together
+//                  as one new snapshot, swapped in atomically; readers
+//                  holding an older one keep it until they let go.
+//                  The snapshot gets its own copy of the node data,
+//                  O(V), so this thread may go on editing and
+//                  searching the graph, and a share of the packed
+//                  arcs. Those are not copied here: the first edit
+//                  after a publish copies them, O(V + E), once, and
+//                  the edits after it patch that copy.
+//                  Only the one thread that edits the graph should
+//                  call this.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::publish() {
+     compact();
+     shared_ptr< GraphSnapshot<NodeType, ArcType> const > pSnapshot(
+         new GraphSnapshot<NodeType, ArcType>( m_pCompact, m_pNodes, m_maxNodes, m_version, m_count ) );
+     m_compactShared = true;
+     atomic_store( &m_pPublished, pSnapshot );
+}
+
+// ----------------------------------------------------------------
+//  Name:           snapshot
+//  Description:    Pins the last published snapshot. Safe to call
+//                  from any thread, at the same time as publish.
+//  Arguments:      None.
+//  Return Value:   The snapshot, or empty if nothing has been
+//                  published yet.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+shared_ptr< GraphSnapshot<NodeType, ArcType> const > Graph<NodeType, ArcType>::snapshot() const {
+     return atomic_load( &m_pPublished );
+}
+
+// ----------------------------------------------------------------
+//  Name:           addListener
+//  Description:    Registers a listener to be told about arc changes.
+//  Arguments:      The listener. The graph does not own it.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::addListener( GraphListener<NodeType, ArcType>* pListener ) {
+     m_listeners.push_back( pListener );
+}
+
+// ----------------------------------------------------------------
+//  Name:           removeListener
+//  Description:    Stops telling a listener about arc changes.
+//  Arguments:      The listener.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::removeListener( GraphListener<NodeType, ArcType>* pListener ) {
+     for( size_t i = 0; i < m_listeners.size(); i++ ) {
+          if( m_listeners[i] == pListener ) {
+              m_listeners.erase( m_listeners.begin() + i );
+              return;
+          }
+     }
+}
+
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::notifyAdded( int from, int to, ArcType weight ) {
+     for( size_t i = 0; i < m_listeners.size(); i++ ) {
+          m_listeners[i]->arcAdded( from, to, weight );
+     }
+}
+
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::notifyRemoved( int from, int to, ArcType weight ) {
+     for( size_t i = 0; i < m_listeners.size(); i++ ) {
+          m_listeners[i]->arcRemoved( from, to, weight );
      }
 }
 
@@ -264,7 +740,7 @@ template<class NodeType, class ArcType>
 GraphArc<NodeType, ArcType>* Graph<NodeType, ArcType>::getArc( int from, int to ) {
      Arc* pArc = 0;
      // make sure the to and from nodes exist
-     if( m_pNodes[from] != 0 && m_pNodes[to] != 0 ) {
+     if( present( from ) && present( to ) ) {
          pArc = m_pNodes[from]->getArc( m_pNodes[to] );
      }
                 
@@ -306,196 +782,1037 @@ void Graph<NodeType, ArcType>::clearMarks() {
      }
 }
 
+// ----------------------------------------------------------------
+//  Name:           indexOf
+//  Description:    Looks up the index a node was added at.
+//  Arguments:      The node to look up.
+//  Return Value:   The index of the node, or -1 if it isn't in the graph.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int Graph<NodeType, ArcType>::indexOf( Node* pNode ) const {
+     typename unordered_map<Node*, int>::const_iterator found = m_indices.find( pNode );
+     if( found == m_indices.end() ) {
+         return -1;
+     }
+     return found->second;
+}
+
+// ----------------------------------------------------------------
+//  Name:           memoryStats
+//  Description:    Adds up the memory the graph uses, part by part:
+//                  the node array, the nodes and what their data
+//                  owns, the arc lists, and every index and cache
+//                  kept alongside them.
+//  Arguments:      None.
+//  Return Value:   The figures, which can be written out as JSON.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+MemoryStats Graph<NodeType, ArcType>::memoryStats() const {
+     MemoryStats stats;
+     // a std::list entry is the arc plus next and previous pointers,
+     // and a hash map entry is the pair plus a next pointer.
+     const unsigned long long listEntry = sizeof( Arc ) + 2 * sizeof( void* );
+     const unsigned long long mapEntry = sizeof( pair<Node* const, int> ) + sizeof( void* );
+
+     stats.nodeArray = (unsigned long long)m_maxNodes * sizeof( Node* );
+     for( int index = 0; index < m_maxNodes; index++ ) {
+          if( m_pNodes[index] != 0 ) {
+              int arcs = (int)m_pNodes[index]->arcList().size();
+              stats.nodeCount++;
+              stats.arcCount += arcs;
+              stats.nodes += sizeof( Node );
+              stats.payload += heapBytes( m_pNodes[index]->data() );
+              stats.arcs += arcs * listEntry;
+          }
+     }
+
+     stats.indices = m_indices.bucket_count() * sizeof( void* ) + m_indices.size() * mapEntry;
+     stats.packed = m_pCompact->memoryBytes();
+     stats.search = ( m_searchCost.capacity() + m_searchPrev.capacity() + m_touched.capacity() ) * sizeof( int ) +
+                    m_searchVisited.wordCount() * sizeof( BitWord );
+     stats.auxiliary = (unsigned long long)m_components.size() * 2 * sizeof( int ) +
+                       ( m_strong.capacity() + m_topoOrder.capacity() + m_topoPosition.capacity() ) * sizeof( int ) +
+                       m_positions.capacity() * sizeof( pair<double, double> ) +
+                       m_listeners.capacity() * sizeof( void* );
+     return stats;
+}
+
+// ----------------------------------------------------------------
+//  Name:           compact
+//  Description:    Gets the packed copy of the arcs, repacking it
+//                  first if the graph has changed since without
+//                  patching it. Patched nodes keep the ids the last
+//                  repack gave them, so a reordering drifts from
+//                  ideal until setOrder asks for a fresh one.
+//  Arguments:      None.
+//  Return Value:   The packed arcs.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+CompactGraph<NodeType, ArcType> const & Graph<NodeType, ArcType>::compact() {
+     if( m_compactVersion != m_version ) {
+         // a snapshot or range may be reading the old one.
+         if( m_compactShared ) {
+             m_pCompact.reset( new CompactGraph<NodeType, ArcType>() );
+             m_compactShared = false;
+         }
+         m_pCompact->build( m_pNodes, m_maxNodes, m_indices, m_order,
+                             m_positions.empty() ? 0 : &m_positions );
+         m_compactVersion = m_version;
+     }
+     return *m_pCompact;
+}
+
+// ----------------------------------------------------------------
+//  Name:           component
+//  Description:    Finds which weakly connected component a node is
+//                  in, ignoring arc directions. Nodes in different
+//                  components can never reach each other.
+//  Arguments:      The node index.
+//  Return Value:   An index standing for the whole component, or -1
+//                  if there is no node at the index.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int Graph<NodeType, ArcType>::component( int index ) {
+     if( !present( index ) ) {
+         return -1;
+     }
+     if( m_componentsStale ) {
+         // start again from the arcs that are left.
+         m_components.reset( m_maxNodes );
+         for( int node = 0; node < m_maxNodes; node++ ) {
+              if( m_pNodes[node] != 0 ) {
+                  typename list<Arc>::const_iterator iter = m_pNodes[node]->arcList().begin();
+                  typename list<Arc>::const_iterator endIter = m_pNodes[node]->arcList().end();
+                  for( ; iter != endIter; ++iter ) {
+                       m_components.unite( node, indexOf( (*iter).node() ) );
+                  }
+              }
+         }
+         m_componentsStale = false;
+     }
+     return m_components.find( index );
+}
+
+// ----------------------------------------------------------------
+//  Name:           connected
+//  Description:    Checks whether two nodes share a component. If
+//                  not, there is no path either way; if so, there
+//                  may still be none against the arc directions.
+//  Arguments:      The two node indices.
+//  Return Value:   true if they are in the same component, false if
+//                  either has no node.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::connected( int from, int to ) {
+     int home = component( from );
+     return home != -1 && home == component( to );
+}
+
+// ----------------------------------------------------------------
+//  Name:           mayReach
+//  Description:    Checks the arc directions between two nodes using
+//                  their strongly connected components, which are
+//                  worked out again once the graph has changed. Arcs
+//                  only lead to the same or later components, so a
+//                  node can't reach one in an earlier component.
+//  Arguments:      The start and target node indices.
+//  Return Value:   false if there is certainly no path.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::mayReach( int from, int to ) {
+     if( component( from ) == -1 || component( to ) == -1 ) {
+         return false;
+     }
+     if( m_strongVersion != m_version ) {
+         strongComponents( m_strong );
+         m_strongVersion = m_version;
+     }
+     return m_strong[from] != -1 && m_strong[to] != -1 && m_strong[from] <= m_strong[to];
+}
+
+// ----------------------------------------------------------------
+//  Name:           setOrder
+//  Description:    Chooses how nodes are numbered the next time the
+//                  graph is packed. Searches run on the packed ids but
+//                  still take and give node indices, so this only
+//                  changes memory layout, not results.
+//  Arguments:      The first argument is the numbering to use.
+//                  The second argument is the position of each node
+//                  by index, needed for ORDER_HILBERT; without it the
+//                  index order is kept.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::setOrder( NodeOrder nodeOrder, vector< pair<double, double> > const & positions ) {
+     m_order = nodeOrder;
+     m_positions = positions;
+     // force a repack on the next search.
+     m_compactVersion = m_version - 1;
+}
+
+// ----------------------------------------------------------------
+//  Name:           packedId
+//  Description:    Looks up a node's id in the packed copy, which
+//                  must be up to date.
+//  Arguments:      The node to look up.
+//  Return Value:   The packed id of the node.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int Graph<NodeType, ArcType>::packedId( Node* pNode ) const {
+     return m_pCompact->internal( indexOf( pNode ) );
+}
+
+// ----------------------------------------------------------------
+//  Name:           unpack
+//  Description:    Turns an array by packed id into one by node index.
+//  Arguments:      The first argument is the array to convert.
+//                  The second argument is true if the values are node
+//                  ids too (-1 for none), so they are converted as well.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::unpack( vector<int>& values, bool ids ) const {
+     if( m_order == ORDER_INDEX ) {
+         return;
+     }
+     vector<int> byIndex( values.size() );
+     for( int id = 0; id < (int)values.size(); id++ ) {
+         int value = values[id];
+         if( ids && value != -1 ) {
+             value = m_pCompact->external( value );
+         }
+         byIndex[m_pCompact->external( id )] = value;
+     }
+     values.swap( byIndex );
+}
+
 // ----------------------------------------------------------------
 //  Name:           depthFirst
 //  Description:    Performs a depth-first traversal on the specified 
-//                  node.
+//                  node. This uses an explicit stack rather than
+//                  recursion so long chains can't overflow the call
+//                  stack, but visits nodes in the same order. Visited
+//                  nodes are tracked in the search bitset, not by node
+//                  marks, so each call starts afresh.
+//                  A visitor returning VISIT_PRUNE stops the search
+//                  going below that node; VISIT_STOP ends it.
 //  Arguments:      The first argument is the starting node
-//                  The second argument is the processing function.
+//                  The second argument is the visitor, called as each
+//                  node is reached (pre-order).
+//                  The third argument is a visitor called once all of
+//                  a node's children are done (post-order).
+//                  The fourth and fifth arguments optionally receive
+//                  the discovery and finish times of each node, by node
+//                  index. Unvisited nodes are left at -1.
 //  Return Value:   None.
 // ----------------------------------------------------------------
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::depthFirst( Node* pNode, void (*pProcess)(Node*) ) {
+template<class Visitor>
+void Graph<NodeType, ArcType>::depthFirst( Node* pNode, Visitor visit ) {
+     depthFirst( pNode, visit, NoVisit() );
+}
+
+template<class NodeType, class ArcType>
+template<class Visitor, class PostVisitor>
+void Graph<NodeType, ArcType>::depthFirst( Node* pNode, Visitor visit, PostVisitor postVisit,
+                                           vector<int>* pDiscovery, vector<int>* pFinish ) {
      if( pNode != 0 ) {
-           // process the current node and mark it
-           pProcess( pNode );
-           pNode->setMarked(true);
+           CompactGraph<NodeType, ArcType> const & graph = compact();
+           resetSearch();
+           SEARCH_STAT( clear() );
+           // each frame is a node and the next arc still to be followed.
+           vector< pair<int, int> > frames;
+           frames.reserve( m_count );
+           int time = 0;
 
-           // go through each connecting node
-           list<Arc>::iterator iter = pNode->arcList().begin();
-           list<Arc>::iterator endIter = pNode->arcList().end();
-        
-		   for( ; iter != endIter; ++iter) {
-			    // process the linked node if it isn't already marked.
-                if ( (*iter).node()->marked() == false ) {
-                   depthFirst( (*iter).node(), pProcess);
-                }            
+           if( pDiscovery != 0 ) {
+               pDiscovery->assign( m_maxNodes, -1 );
+           }
+           if( pFinish != 0 ) {
+               pFinish->assign( m_maxNodes, -1 );
+           }
+
+           // process the starting node and mark it
+           int start = packedId( pNode );
+           VisitResult result = callVisitor( visit, pNode );
+           markVisited( start, -1 );
+           SEARCH_STAT( settled++ );
+           if( result == VISIT_STOP ) {
+               return;
+           }
+           if( pDiscovery != 0 ) {
+               (*pDiscovery)[graph.external( start )] = time;
+           }
+           time++;
+           // a pruned node starts with no arcs left to follow.
+           frames.push_back( make_pair( start, result == VISIT_PRUNE ? graph.endArc( start )
+                                                                     : graph.firstArc( start ) ) );
+           SEARCH_STAT( pushes++ );
+           SEARCH_STAT( queued( 1 ) );
+
+           while( !frames.empty() ) {
+                int current = frames.back().first;
+                int& arc = frames.back().second;
+                int endArc = graph.endArc( current );
+
+                // skip over any linked nodes that are already visited.
+                while( arc != endArc && m_searchVisited.test( graph.target( arc ) ) ) {
+                     SEARCH_STAT( scanned++ );
+                     ++arc;
+                }
+
+                if( arc != endArc ) {
+                     // descend into the next unvisited node.
+                     int child = graph.target( arc );
+                     ++arc;
+                     result = callVisitor( visit, graph.node( child ) );
+                     markVisited( child, current );
+                     SEARCH_STAT( scanned++ );
+                     SEARCH_STAT( relaxed++ );
+                     SEARCH_STAT( settled++ );
+                     if( result == VISIT_STOP ) {
+                         return;
+                     }
+                     if( pDiscovery != 0 ) {
+                         (*pDiscovery)[graph.external( child )] = time;
+                     }
+                     time++;
+                     frames.push_back( make_pair( child, result == VISIT_PRUNE ? graph.endArc( child )
+                                                                               : graph.firstArc( child ) ) );
+                     SEARCH_STAT( pushes++ );
+                     SEARCH_STAT( queued( (long long)frames.size() ) );
+                }
+                else {
+                     // every child is done, so the node is finished.
+                     if( callVisitor( postVisit, graph.node( current ) ) == VISIT_STOP ) {
+                         return;
+                     }
+                     if( pFinish != 0 ) {
+                         (*pFinish)[graph.external( current )] = time;
+                     }
+                     time++;
+                     frames.pop_back();
+                     SEARCH_STAT( pops++ );
+                }
            }
      }
 }
 
 // ----------------------------------------------------------------
 //  Name:           breadthFirst
-//  Description:    Performs a depth-first traversal the starting node
-//                  specified as an input parameter.
+//  Description:    Performs a breadth-first traversal from the starting
+//                  node specified as an input parameter. Visited nodes
+//                  are tracked in the search bitset, not by node marks.
+//                  A visitor returning VISIT_PRUNE skips that node's
+//                  children; VISIT_STOP ends the traversal.
+//                  Given a CompressedGraph, the search runs on its
+//                  arcs instead, which are taken in target order.
 //  Arguments:      The first parameter is the starting node
-//                  The second parameter is the processing function.
+//                  The second parameter is the visitor.
 //  Return Value:   None.
 // ----------------------------------------------------------------
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::breadthFirst( Node* pNode, void (*pProcess)(Node*) ) {
-   if( pNode != 0 ) {
-	  queue<Node*> nodeQueue;        
-	  // place the first node on the queue, and mark it.
-      nodeQueue.push( pNode );
-      pNode->setMarked(true);
+template<class Visitor>
+void Graph<NodeType, ArcType>::breadthFirst( Node* pNode, Visitor visit ) {
+   breadthFirstOver( compact(), pNode, visit );
+}
+
+template<class NodeType, class ArcType>
+template<class Visitor>
+void Graph<NodeType, ArcType>::breadthFirst( CompressedGraph<NodeType, ArcType> const & arcs, Node* pNode, Visitor visit ) {
+   breadthFirstOver( arcs, pNode, visit );
+}
+
+template<class NodeType, class ArcType>
+template<class Arcs, class Visitor>
+void Graph<NodeType, ArcType>::breadthFirstOver( Arcs const & arcs, Node* pNode, Visitor visit ) {
+   // a node not in the graph, or past the end of the arcs given,
+   // has nothing to search.
+   int index = indexOf( pNode );
+   if( index != -1 && index < arcs.size() ) {
+      resetSearch();
+      SEARCH_STAT( clear() );
+      // the queue is a plain array read from the front.
+      vector<int> nodeQueue;
+      nodeQueue.reserve( m_count );
+
+      // place the first node on the queue, and mark it.
+      int start = arcs.internal( index );
+      nodeQueue.push_back( start );
+      markVisited( start, -1 );
+      SEARCH_STAT( pushes++ );
+      SEARCH_STAT( queued( 1 ) );
 
       // loop through the queue while there are nodes in it.
-      while( nodeQueue.size() != 0 ) {
+      for( size_t front = 0; front < nodeQueue.size(); front++ ) {
+         int current = nodeQueue[front];
+         SEARCH_STAT( pops++ );
+         SEARCH_STAT( settled++ );
          // process the node at the front of the queue.
-         pProcess( nodeQueue.front() );
+         VisitResult result = callVisitor( visit, nodeOf( arcs, current ) );
+         if( result == VISIT_STOP ) {
+             break;
+         }
+         if( result == VISIT_PRUNE ) {
+             continue;
+         }
 
          // add all of the child nodes that have not been 
-         // marked into the queue
-         list<Arc>::const_iterator iter = nodeQueue.front()->arcList().begin();
-         list<Arc>::const_iterator endIter = nodeQueue.front()->arcList().end();
-         
-		 for( ; iter != endIter; iter++ ) {
-              if ( (*iter).node()->marked() == false) {
-				 // mark the node and add it to the queue.
-                 (*iter).node()->setMarked(true);
-                 nodeQueue.push( (*iter).node() );
+         // visited into the queue
+         arcs.forEachArc( current, [&]( int child, ArcType ) {
+              SEARCH_STAT( scanned++ );
+              if( !m_searchVisited.test( child ) ) {
+                 markVisited( child, current );
+                 nodeQueue.push_back( child );
+                 SEARCH_STAT( relaxed++ );
+                 SEARCH_STAT( pushes++ );
               }
-         }
-
-         // dequeue the current node.
-         nodeQueue.pop();
+         } );
+         SEARCH_STAT( queued( (long long)( nodeQueue.size() - front - 1 ) ) );
       }
    }  
 }
 
+// ----------------------------------------------------------------
+//  Name:           bfsRange
+//  Description:    A breadth-first traversal to pull nodes from one
+//                  at a time, for example to take the first few or to
+//                  step two traversals in turn:
+//                      for (Node* pNode : graph.bfsRange(pStart)) ...
+//                  Nodes come in the same order as from breadthFirst,
+//                  but nothing is marked and arcs are only followed
+//                  as the range moves on. The range shares the packed
+//                  arcs as they are now, so edits made while it is in
+//                  use copy them rather than change them under it and
+//                  it goes on walking the graph as it was; nodes
+//                  removed meanwhile must not be dereferenced.
+//  Arguments:      The starting node, or 0 for an empty range.
+//  Return Value:   The range.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+BreadthFirstRange<NodeType, ArcType> Graph<NodeType, ArcType>::bfsRange(Node* pStart)
+{
+	compact();
+	m_compactShared = true;
+	return BreadthFirstRange<NodeType, ArcType>(m_pCompact, pStart != 0 ? packedId(pStart) : -1);
+}
+
+// ----------------------------------------------------------------
+//  Name:           dfsRange
+//  Description:    A depth-first traversal to pull nodes from one at
+//                  a time, in the same order as from depthFirst. See
+//                  bfsRange.
+//  Arguments:      The starting node, or 0 for an empty range.
+//  Return Value:   The range.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+DepthFirstRange<NodeType, ArcType> Graph<NodeType, ArcType>::dfsRange(Node* pStart)
+{
+	compact();
+	m_compactShared = true;
+	return DepthFirstRange<NodeType, ArcType>(m_pCompact, pStart != 0 ? packedId(pStart) : -1);
+}
+
 // ----------------------------------------------------------------
 //  Name:           breadthFirstPlus
-//  Description:    Performs a depth-first traversal from the starting node
-//                  to the target node specified as input parameters.
+//  Description:    Performs a breadth-first traversal from the starting
+//                  node to the target node specified as input
+//                  parameters. The search state lives in the dense
+//                  search arrays; when the target is found, the nodes
+//                  on its path get their previous pointers set, so
+//                  tracePath gives the route.
 //  Arguments:      The first parameter is the starting node
 //					The second parameter is the target node
-//                  The third parameter is the processing function.
+//                  The third parameter is the visitor, which can return
+//                  VISIT_PRUNE or VISIT_STOP like in breadthFirst.
 //  Return Value:   None.
 // ----------------------------------------------------------------
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::breadthFirstPlus(Node* pNode, Node* pTarget, void(*pProcess)(Node*)) {
+template<class Visitor>
+void Graph<NodeType, ArcType>::breadthFirstPlus(Node* pNode, Node* pTarget, Visitor visit) {
 	if (pNode != 0) {
-		queue<Node*> nodeQueue;
+		CompactGraph<NodeType, ArcType> const & graph = compact();
+		resetSearch();
+		SEARCH_STAT(clear());
+		vector<int> nodeQueue;
+		nodeQueue.reserve(m_count);
+		int target = pTarget != 0 ? packedId(pTarget) : -1;
 		bool found = false;
+
 		// place the first node on the queue, and mark it.
-		nodeQueue.push(pNode);
-		pNode->setMarked(true);
+		int start = packedId(pNode);
+		nodeQueue.push_back(start);
+		markVisited(start, -1);
+		SEARCH_STAT(pushes++);
+		SEARCH_STAT(queued(1));
 
 		// loop through the queue while there are nodes in it.
-		while (nodeQueue.size() != 0 && !found) {
+		for (size_t front = 0; front < nodeQueue.size() && !found; front++) {
+			int current = nodeQueue[front];
+			SEARCH_STAT(pops++);
+			SEARCH_STAT(settled++);
 			// process the node at the front of the queue.
-			pProcess(nodeQueue.front());
+			VisitResult result = callVisitor(visit, graph.node(current));
+			if (result == VISIT_STOP) {
+				break;
+			}
+			if (result == VISIT_PRUNE) {
+				continue;
+			}
 
 			// add all of the child nodes that have not been 
-			// marked into the queue
-			list<Arc>::const_iterator iter = nodeQueue.front()->arcList().begin();
-			list<Arc>::const_iterator endIter = nodeQueue.front()->arcList().end();
-
-			for (; iter != endIter && !found; iter++) {
+			// visited into the queue
+			for (int arc = graph.firstArc(current); arc != graph.endArc(current) && !found; arc++) {
+				int child = graph.target(arc);
+				SEARCH_STAT(scanned++);
 				//if the node is our target set found to true
-				if ((*iter).node() == pTarget)
+				if (child == target)
 				{
-					(*iter).node()->setPrev(nodeQueue.front());
-					found = 1;
+					markVisited(child, current);
+					SEARCH_STAT(relaxed++);
+					found = true;
 				}
 				//else add it to the queue
-				else if ((*iter).node()->marked() == false) {
-					// mark the node and add it to the queue.
-					(*iter).node()->setMarked(true);
-					(*iter).node()->setPrev(nodeQueue.front());
-					nodeQueue.push((*iter).node());
+				else if (!m_searchVisited.test(child)) {
+					markVisited(child, current);
+					nodeQueue.push_back(child);
+					SEARCH_STAT(relaxed++);
+					SEARCH_STAT(pushes++);
 				}
 			}
+			SEARCH_STAT(queued((long long)(nodeQueue.size() - front - 1)));
+		}
 
-			// dequeue the current node.
-			nodeQueue.pop();
-			
+		if (found) {
+			vector<Node*> path;
+			searchPath(graph, target, path);
 		}
 	}
 }
 
+// ----------------------------------------------------------------
+//  Name:           breadthFirstHybrid
+//  Description:    Direction-optimizing breadth-first search. Small
+//                  levels are expanded top-down from a queue, as in
+//                  breadthFirstPlus. Once the frontier's arcs outweigh
+//                  the unvisited nodes' arcs it switches to bottom-up,
+//                  where each unvisited node looks for any parent in a
+//                  frontier bitmap, and switches back as it shrinks.
+//                  The bottom-up levels handle the visited, frontier
+//                  and next sets 64 nodes to a word with bitwise
+//                  operations; there is no explicit SIMD, and the
+//                  parent look-up itself is a plain loop per node.
+//                  Node marks are not used or changed.
+//  Arguments:      The first parameter is the starting node
+//                  The second parameter receives the parent index of
+//                  each node, -1 for the start and unreached nodes.
+//                  The third parameter receives the level of each
+//                  node, -1 if unreached.
+//  Return Value:   None.
+// ----------------------------------------------------------------
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::UCS(Node* pStart, Node* pTarget, void(*pProcess)(Node*), std::vector<Node*>& path)
-{
-	//init distances and unmark
-	prepUCS();
-	pStart->setData(pair<string, int>(pStart->data().first, 0));
+void Graph<NodeType, ArcType>::breadthFirstHybrid(Node* pNode, vector<int>& parent, vector<int>& level) {
+	parent.assign(m_maxNodes, -1);
+	level.assign(m_maxNodes, -1);
+	if (pNode == 0) {
+		return;
+	}
 
-	cout << "////===== UCS from " << pStart->data().first << " to " << pTarget->data().first << endl;
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	int n = graph.size();
+	// switch thresholds from Beamer et al.
+	const int alpha = 14;
+	const int beta = 24;
 
-	//make & set up queue
-	priority_queue<Node*, vector<Node*>, NodeSearchCostComparer<NodeType, ArcType>> pq;
-	
-	//Start of UCS
-	pq.push(pStart);
-	pStart->setMarked(true);
-	
-	//Priority Queueue loop
-	while (!pq.empty() && pq.top() != pTarget)
-	{
+	BitSet visited(n);
+	BitSet frontier(n);
+	BitSet next(n);
+	vector<int> queue;
+	vector<int> nextQueue;
+	queue.reserve(n);
+	nextQueue.reserve(n);
 
-		//cout << "TOP: " << pq.top()->data().first << endl;
+	int start = packedId(pNode);
+	visited.set(start);
+	level[start] = 0;
+	queue.push_back(start);
 
-		//for each child node
-		list<Arc>::const_iterator iter = pq.top()->arcList().begin();
-		list<Arc>::const_iterator endIter = pq.top()->arcList().end();
-	
-		//Process all children of the top node
-		for (; iter != endIter; iter++) {
+	// arcs still leaving unvisited nodes.
+	long long unexploredArcs = graph.arcCount() - graph.degree(start);
+	long long frontierArcs = graph.degree(start);
+	int frontierSize = 1;
+	bool bottomUp = false;
+	int depth = 0;
 
-			//if the previous node is not top of the queue
-			if ((*iter).node() != pq.top()->getPrev())
-			{
-				//cout << "Checking: " << pq.top()->data().first << " -> " << (*iter).node()->data().first << " ";
+	while (frontierSize != 0) {
+		depth++;
+		if (!bottomUp && frontierArcs > unexploredArcs / alpha) {
+			// move the queue into the frontier bitmap.
+			frontier.clear();
+			for (size_t i = 0; i < queue.size(); i++) {
+				frontier.set(queue[i]);
+			}
+			bottomUp = true;
+		}
+		else if (bottomUp && frontierSize < n / beta) {
+			// move the frontier bitmap back into a queue, in id order.
+			queue.clear();
+			for (int w = 0; w < frontier.wordCount(); w++) {
+				BitWord bits = frontier.word(w);
+				while (bits != 0) {
+					queue.push_back(w * 64 + lowestBit(bits));
+					bits &= bits - 1;
+				}
+			}
+			bottomUp = false;
+		}
 
-				//Get total weight of this route
-				int c = pq.top()->getArc((*iter).node())->weight() + pq.top()->data().second;
+		frontierArcs = 0;
+		if (bottomUp) {
+			// 64 ids at a time: one mask picks out the unvisited nodes,
+			// the ones joining the next level are gathered in one word,
+			// and that word is stored, added to visited and counted with
+			// whole-word operations. Only the look for a parent among a
+			// node's in-arcs goes node by node.
+			frontierSize = 0;
+			int words = visited.wordCount();
+			for (int w = 0; w < words; w++) {
+				BitWord unvisited = ~visited.word(w);
+				if (w == words - 1 && (n & 63) != 0) {
+					unvisited &= (BitWord(1) << (n & 63)) - 1;
+				}
+				BitWord found = 0;
+				while (unvisited != 0) {
+					int bit = lowestBit(unvisited);
+					unvisited &= unvisited - 1;
+					int v = w * 64 + bit;
+					for (int arc = graph.firstInArc(v); arc != graph.endInArc(v); arc++) {
+						int u = graph.source(arc);
+						if (frontier.test(u)) {
+							parent[v] = u;
+							level[v] = depth;
+							found |= BitWord(1) << bit;
+							frontierArcs += graph.degree(v);
+							break;
+						}
+					}
+				}
+				next.word(w) = found;
+				visited.word(w) |= found;
+				frontierSize += popCount(found);
+			}
+			frontier.swap(next);
+		}
+		else {
+			nextQueue.clear();
+			for (size_t i = 0; i < queue.size(); i++) {
+				int u = queue[i];
+				for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+					int v = graph.target(arc);
+					if (!visited.test(v)) {
+						visited.set(v);
+						parent[v] = u;
+						level[v] = depth;
+						nextQueue.push_back(v);
+						frontierArcs += graph.degree(v);
+					}
+				}
+			}
+			queue.swap(nextQueue);
+			frontierSize = (int)queue.size();
+		}
+		unexploredArcs -= frontierArcs;
+	}
+	unpack(parent, true);
+	unpack(level, false);
+}
 
-				//cout << "[" << c << " < " << ((*iter).node()->data().second) << "]" << endl;
+// ----------------------------------------------------------------
+//  Name:           breadthFirstParallel
+//  Description:    Level-synchronous breadth-first search spread
+//                  over several threads. Each level's frontier is
+//                  handed out in chunks, and a thread claims a node
+//                  for the next level by swapping its parent from -1
+//                  with compare-and-swap, so each node is claimed
+//                  once. Node marks are not used or changed.
+//  Arguments:      The first parameter is the starting node
+//                  The second parameter receives the parent index of
+//                  each node, -1 for the start and unreached nodes.
+//                  The third parameter receives the level of each
+//                  node, -1 if unreached.
+//                  The fourth parameter is the number of threads, or
+//                  0 for one per core.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::breadthFirstParallel(Node* pNode, vector<int>& parent, vector<int>& level, int threads) {
+	parent.assign(m_maxNodes, -1);
+	level.assign(m_maxNodes, -1);
+	if (pNode == 0) {
+		return;
+	}
 
-				//if it's lower than the weight of the current route
-				if (c < ((*iter).node()->data().second))
-				{
-					//cout << "True, " << (*iter).node()->data().first << " weight is now " << c << ", previous is now " << pq.top()->data().first << endl;
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	int n = graph.size();
+	int workers = workerCount(threads);
+	// frontier nodes handed to a thread at a time.
+	const int chunk = 64;
 
-					//Set the node's internal weight to the arc from previous plus internal weight of previous
-					(*iter).node()->setData(pair<string, int>((*iter).node()->data().first, c));
-					//Set previous pointer of the node to the previous node in the new path
-					(*iter).node()->setPrev(pq.top());
+	unique_ptr<atomic<int>[]> claimed(new atomic<int>[n]);
+	for (int i = 0; i < n; i++) {
+		claimed[i].store(-1, memory_order_relaxed);
+	}
+
+	vector<int> frontier(n);
+	vector<int> next(n);
+	int frontierSize = 1;
+	int depth = 0;
+	atomic<int> cursor(0);
+	atomic<int> nextSize(0);
+	Barrier barrier(workers);
+
+	int start = packedId(pNode);
+	// the start claims itself so nobody else can.
+	claimed[start].store(start, memory_order_relaxed);
+	level[start] = 0;
+	frontier[0] = start;
+
+	auto work = [&](int worker) {
+		vector<int> local;
+		while (true) {
+			local.clear();
+			// take chunks of the frontier until it is used up.
+			int first;
+			while ((first = cursor.fetch_add(chunk)) < frontierSize) {
+				int last = first + chunk < frontierSize ? first + chunk : frontierSize;
+				for (int i = first; i < last; i++) {
+					int u = frontier[i];
+					for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+						int v = graph.target(arc);
+						int unclaimed = -1;
+						if (claimed[v].load(memory_order_relaxed) == -1 &&
+							claimed[v].compare_exchange_strong(unclaimed, u)) {
+							level[v] = depth + 1;
+							local.push_back(v);
+						}
+					}
 				}
+			}
 
-				else
-				{
-					//if ((*iter).node()->getPrev() != 0)
-						//cout << "False, " << (*iter).node()->data().first << " remaining " << ((*iter).node()->data().second) << ", previous remains " << (*iter).node()->getPrev()->data().first << endl;
-					//else cout << "False, " << (*iter).node()->data().first << " remaining " << ((*iter).node()->data().second) << ", previous remains NULL" << endl;
+			// add this thread's share of the next level.
+			int offset = nextSize.fetch_add((int)local.size());
+			for (size_t i = 0; i < local.size(); i++) {
+				next[offset + i] = local[i];
+			}
+
+			barrier.wait();
+			if (worker == 0) {
+				frontier.swap(next);
+				frontierSize = nextSize.load();
+				nextSize.store(0);
+				cursor.store(0);
+				depth++;
+			}
+			barrier.wait();
+
+			if (frontierSize == 0) {
+				break;
+			}
+		}
+	};
+
+	vector<thread> pool;
+	for (int t = 1; t < workers; t++) {
+		pool.push_back(thread(work, t));
+	}
+	work(0);
+	for (size_t t = 0; t < pool.size(); t++) {
+		pool[t].join();
+	}
+
+	for (int i = 0; i < n; i++) {
+		parent[i] = claimed[i].load(memory_order_relaxed);
+	}
+	parent[start] = -1;
+	unpack(parent, true);
+	unpack(level, false);
+}
+
+// ----------------------------------------------------------------
+//  Name:           breadthFirstMultiSource
+//  Description:    Runs a breadth-first search from every source at
+//                  once (MS-BFS). Each node keeps one bit per source
+//                  for "seen" and "in the frontier", so a single scan
+//                  of a node's arcs moves all of its searches along
+//                  together, 64 sources per word.
+//  Arguments:      The first parameter is the list of starting nodes.
+//                  The second parameter receives the hop count from
+//                  each source (first index) to each node (second
+//                  index), -1 if unreachable.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::breadthFirstMultiSource(vector<Node*> const & sources, vector< vector<int> >& hops) {
+	int k = (int)sources.size();
+	hops.assign(k, vector<int>(m_maxNodes, -1));
+	if (k == 0) {
+		return;
+	}
+
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	int n = graph.size();
+	// words of source bits per node.
+	int words = (k + 63) / 64;
+
+	vector<BitWord> seen((size_t)n * words, 0);
+	vector<BitWord> frontier((size_t)n * words, 0);
+	vector<BitWord> next((size_t)n * words, 0);
+
+	for (int s = 0; s < k; s++) {
+		int start = packedId(sources[s]);
+		BitWord bit = BitWord(1) << (s & 63);
+		seen[(size_t)start * words + (s >> 6)] |= bit;
+		frontier[(size_t)start * words + (s >> 6)] |= bit;
+		hops[s][start] = 0;
+	}
+
+	int depth = 0;
+	bool active = true;
+	while (active) {
+		depth++;
+		// push every frontier bit along every arc.
+		for (int u = 0; u < n; u++) {
+			BitWord const* pFrontier = &frontier[(size_t)u * words];
+			BitWord any = 0;
+			for (int w = 0; w < words; w++) {
+				any |= pFrontier[w];
+			}
+			if (any == 0) {
+				continue;
+			}
+			for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+				BitWord* pNext = &next[(size_t)graph.target(arc) * words];
+				for (int w = 0; w < words; w++) {
+					pNext[w] |= pFrontier[w];
 				}
+			}
+		}
 
-				//if not marked
-				if ((*iter).node()->marked() == false) {
-					//add it to the queue and mark
-					pq.push((*iter).node());
-					//cout << "Queueing:  " << (*iter).node()->data().first << endl;
-					(*iter).node()->setMarked(true);
+		// keep only the sources reaching each node for the first time.
+		active = false;
+		for (int v = 0; v < n; v++) {
+			BitWord* pNext = &next[(size_t)v * words];
+			BitWord* pSeen = &seen[(size_t)v * words];
+			for (int w = 0; w < words; w++) {
+				BitWord fresh = pNext[w] & ~pSeen[w];
+				pSeen[w] |= fresh;
+				pNext[w] = fresh;
+				if (fresh != 0) {
+					active = true;
+				}
+				while (fresh != 0) {
+					hops[w * 64 + lowestBit(fresh)][v] = depth;
+					fresh &= fresh - 1;
 				}
 			}
 		}
-		//cout << "Popping: " << pq.top()->data().first << endl << endl;
+		frontier.swap(next);
+		next.assign(next.size(), 0);
+	}
+	for (int s = 0; s < k; s++) {
+		unpack(hops[s], false);
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           UCS
+//  Description:    Uniform cost search from the start node to the
+//                  target node. The search runs on the dense search
+//                  arrays and only resets what the previous search
+//                  touched; the nodes on the resulting path get their
+//                  cost and previous pointer set, as before. A target
+//                  in another component is turned down before any
+//                  search starts. With setSearchQueue(QUEUE_BUCKET)
+//                  and whole non-negative weights, the frontier is
+//                  kept in Dial's buckets (or a radix heap for heavy
+//                  weights) instead of a binary heap.
+//                  Whatever the setting, if every arc being searched has
+//                  the same weight the frontier is a plain FIFO queue
+//                  (a breadth-first search), and if the weights are
+//                  all 0 or 1 it is the deque of 0-1 BFS.
+//                  Given a CompressedGraph, the search runs on its
+//                  arcs instead, with its components and weights.
+//  Arguments:      The first parameter is the starting node
+//					The second parameter is the target node
+//                  The third parameter is the visitor, called as each
+//                  node leaves the queue, the target included.
+//                  VISIT_PRUNE skips its arcs, VISIT_STOP ends the
+//                  search where it is, with no path.
+//                  The fourth parameter receives the path, target first.
+//                  It is left empty if the target wasn't reached.
+//                  Given a PathResult instead, it is refilled with the
+//                  path, start first, and the nodes are left alone.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Visitor, class Path>
+void Graph<NodeType, ArcType>::UCS(Node* pStart, Node* pTarget, Visitor visit, Path& path)
+{
+	SEARCH_STAT(clear());
+	startPath(path);
+	// no search can reach a target in another component, or a node
+	// that isn't in the graph.
+	if (!connected(indexOf(pStart), indexOf(pTarget))) {
+		return;
+	}
+	UCSQueued(compact(), pStart, pTarget, visit, path);
+}
+
+template<class NodeType, class ArcType>
+template<class Visitor, class Path>
+void Graph<NodeType, ArcType>::UCS(CompressedGraph<NodeType, ArcType> const & arcs, Node* pStart, Node* pTarget, Visitor visit, Path& path)
+{
+	SEARCH_STAT(clear());
+	startPath(path);
+	// the compressed arcs know their own components.
+	int start = indexOf(pStart);
+	int target = indexOf(pTarget);
+	if (start == -1 || target == -1 || start >= arcs.size() || target >= arcs.size() ||
+	    arcs.component(arcs.internal(start)) != arcs.component(arcs.internal(target))) {
+		return;
+	}
+	UCSQueued(arcs, pStart, pTarget, visit, path);
+}
+
+// ----------------------------------------------------------------
+//  Name:           UCSQueued
+//  Description:    Picks the queue for UCS from the weights of the
+//                  arcs being searched and runs the search with it.
+//                  The range is the arcs' own: a rebuild makes it
+//                  exact and patches only ever widen it, so after
+//                  removals it may pick a more general queue than
+//                  needed, but never one that is wrong.
+//  Arguments:      The arcs to search, then as for UCS.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Arcs, class Visitor, class Path>
+void Graph<NodeType, ArcType>::UCSQueued(Arcs const & arcs, Node* pStart, Node* pTarget, Visitor visit, Path& path)
+{
+	if (arcs.minWeight() == arcs.maxWeight() && arcs.minWeight() >= 0) {
+		// every arc costs the same, so this is a breadth-first search.
+		FifoQueue pq;
+		UCSOver(arcs, pq, pStart, pTarget, visit, path);
+		return;
+	}
+	if (is_integral<ArcType>::value && arcs.minWeight() >= 0 && arcs.maxWeight() <= 1) {
+		ZeroOneQueue pq;
+		UCSOver(arcs, pq, pStart, pTarget, visit, path);
+		return;
+	}
+	if (m_searchQueue == QUEUE_BUCKET && is_integral<ArcType>::value && arcs.minWeight() >= 0) {
+		if (arcs.maxWeight() <= DIAL_LIMIT) {
+			DialQueue pq((int)arcs.maxWeight());
+			UCSOver(arcs, pq, pStart, pTarget, visit, path);
+		}
+		else {
+			RadixHeap pq;
+			UCSOver(arcs, pq, pStart, pTarget, visit, path);
+		}
+		return;
+	}
+	priority_queue<pair<int, int>, vector< pair<int, int> >, greater< pair<int, int> > > pq;
+	UCSOver(arcs, pq, pStart, pTarget, visit, path);
+}
+
+template<class NodeType, class ArcType>
+template<class Arcs, class Queue, class Visitor, class Path>
+void Graph<NodeType, ArcType>::UCSOver(Arcs const & arcs, Queue& pq, Node* pStart, Node* pTarget, Visitor visit, Path& path)
+{
+	// the callers check this, but an index the arcs don't cover
+	// would read past their ends.
+	int startIndex = indexOf(pStart);
+	int targetIndex = indexOf(pTarget);
+	if (startIndex == -1 || targetIndex == -1 || startIndex >= arcs.size() || targetIndex >= arcs.size()) {
+		return;
+	}
+
+	//init distances and unmark
+	resetSearch();
+
+	cout << "////===== UCS from " << pStart->data().first << " to " << pTarget->data().first << endl;
+
+	//the queue holds (cost, node index)
+	typedef pair<int, int> Entry;
+	int start = arcs.internal(startIndex);
+	int target = arcs.internal(targetIndex);
+	
+	//Start of UCS
+	touch(start, 0, -1);
+	pq.push(Entry(0, start));
+	SEARCH_STAT(pushes++);
+	SEARCH_STAT(queued(1));
+	
+	//Priority Queueue loop
+	while (!pq.empty())
+	{
+		Entry top = pq.top();
 		pq.pop();
+		SEARCH_STAT(pops++);
+		int u = top.second;
+		//skip entries beaten since they were queued, and settled nodes
+		if (top.first != m_searchCost[u] || m_searchVisited.test(u)) {
+			continue;
+		}
+		m_searchVisited.set(u);
+		SEARCH_STAT(settled++);
+
+		// the target is visited too; once it is settled the path is
+		// final, whatever the visitor says.
+		VisitResult result = callVisitor(visit, nodeOf(arcs, u));
+		if (u == target) {
+			break;
+		}
+		if (result == VISIT_STOP) {
+			// the target's cost is only a guess, so give no path.
+			return;
+		}
+		if (result == VISIT_PRUNE) {
+			continue;
+		}
+
+		//Process all children of the top node
+		arcs.forEachArc(u, [&](int v, ArcType weight) {
+			SEARCH_STAT(scanned++);
+			//Get total weight of this route
+			int c = top.first + weight;
+
+			//if it's lower than the weight of the current route
+			if (c < m_searchCost[v]) {
+				touch(v, c, u);
+				pq.push(Entry(c, v));
+				SEARCH_STAT(relaxed++);
+				SEARCH_STAT(pushes++);
+			}
+		});
+		SEARCH_STAT(queued((long long)pq.size()));
 	}
 	
 	//Add the nodes to path
+	searchPath(arcs, target, path);
+}
+
+// ----------------------------------------------------------------
+//  Name:           tracePath
+//  Description:    Follows the previous pointers left by a search
+//                  back from the target to the start.
+//  Arguments:      The first parameter is the target node
+//                  The second parameter receives the path, target first.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::tracePath(Node* pTarget, std::vector<Node*>& path)
+{
 	while (pTarget->getPrev() != NULL)
 	{
 		path.push_back(pTarget);
@@ -504,8 +1821,889 @@ void Graph<NodeType, ArcType>::UCS(Node* pStart, Node* pTarget, void(*pProcess)(
 	path.push_back(pTarget);
 }
 
+// ----------------------------------------------------------------
+//  Name:           resetSearch
+//  Description:    Readies the search arrays, resetting only the
+//                  nodes the previous search touched.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::resetSearch()
+{
+	if ((int)m_searchCost.size() != m_maxNodes) {
+		m_searchCost.assign(m_maxNodes, INT_MAX);
+		m_searchPrev.assign(m_maxNodes, -1);
+		m_searchVisited.resize(m_maxNodes);
+		m_touched.clear();
+	}
+	for (size_t i = 0; i < m_touched.size(); i++) {
+		m_searchCost[m_touched[i]] = INT_MAX;
+		m_searchPrev[m_touched[i]] = -1;
+		m_searchVisited.reset(m_touched[i]);
+	}
+	m_touched.clear();
+}
+
+// ----------------------------------------------------------------
+//  Name:           touch
+//  Description:    Sets a node's search cost and previous index,
+//                  remembering it for the next reset.
+//  Arguments:      The node index, its new cost and previous index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::touch(int id, int cost, int prev)
+{
+	if (m_searchCost[id] == INT_MAX && !m_searchVisited.test(id)) {
+		m_touched.push_back(id);
+	}
+	m_searchCost[id] = cost;
+	m_searchPrev[id] = prev;
+}
+
+// ----------------------------------------------------------------
+//  Name:           markVisited
+//  Description:    Sets a node's visited bit and previous index,
+//                  remembering it for the next reset.
+//  Arguments:      The node index and its previous index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::markVisited(int id, int prev)
+{
+	if (m_searchCost[id] == INT_MAX && !m_searchVisited.test(id)) {
+		m_touched.push_back(id);
+	}
+	m_searchVisited.set(id);
+	m_searchPrev[id] = prev;
+}
+
+// ----------------------------------------------------------------
+//  Name:           searchPath
+//  Description:    Builds a path from the search arrays. This is
+//                  the only place searches write to the nodes: every
+//                  search that hands back a path of nodes sets the
+//                  cost and previous pointer of the nodes on it, and
+//                  of no others, so tracePath and code reading
+//                  data().second work on that path. Searches that
+//                  answer in arrays or a PathResult write nothing,
+//                  and no search uses or changes the node marks.
+//  Arguments:      The first parameter is the arcs that were searched
+//                  The second parameter is the target node id
+//                  The third parameter receives the path, target
+//                  first. It is left empty if the target wasn't reached.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Arcs>
+void Graph<NodeType, ArcType>::searchPath(Arcs const & arcs, int target, std::vector<Node*>& path)
+{
+	if (m_searchCost[target] == INT_MAX && !m_searchVisited.test(target)) {
+		return;
+	}
+	for (int id = target; id != -1; id = m_searchPrev[id]) {
+		int prev = m_searchPrev[id];
+		// breadth-first searches have no costs to write.
+		Node* pNode = nodeOf(arcs, id);
+		if (m_searchCost[id] != INT_MAX) {
+			pNode->setData(pair<string, int>(pNode->data().first, m_searchCost[id]));
+		}
+		pNode->setPrev(prev == -1 ? NULL : nodeOf(arcs, prev));
+		path.push_back(pNode);
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           searchPath
+//  Description:    Copies a path out of the search arrays into a
+//                  PathResult, reusing its buffers. Nothing is
+//                  written to the nodes.
+//  Arguments:      The first parameter is the arcs that were searched
+//                  The second parameter is the target node id
+//                  The third parameter receives the path, start first.
+//                  It is left empty if the target wasn't reached.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Arcs>
+void Graph<NodeType, ArcType>::searchPath(Arcs const & arcs, int target, PathResult& result)
+{
+	result.clear();
+	if (m_searchCost[target] == INT_MAX) {
+		return;
+	}
+	for (int id = target; id != -1; id = m_searchPrev[id]) {
+		result.nodes.push_back(arcs.external(id));
+		result.costs.push_back(m_searchCost[id]);
+	}
+	reverse(result.nodes.begin(), result.nodes.end());
+	reverse(result.costs.begin(), result.costs.end());
+}
+
+// ----------------------------------------------------------------
+//  Name:           UCSMany
+//  Description:    Uniform cost search from one start node to a set
+//                  of targets. A single search runs until the last
+//                  target leaves the queue, instead of one search per
+//                  target, and only the nodes it touched are reset
+//                  for the next one.
+//  Arguments:      The first parameter is the starting node
+//                  The second parameter is the list of targets.
+//                  The third parameter receives a path per target,
+//                  target first, empty if the target is unreachable.
+//                  The fourth parameter receives the cost per target,
+//                  INT_MAX if unreachable.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::UCSMany(Node* pStart, vector<Node*> const & targets, vector< vector<Node*> >& paths, vector<int>& costs)
+{
+	paths.assign(targets.size(), vector<Node*>());
+	costs.assign(targets.size(), INT_MAX);
+	if (indexOf(pStart) == -1 || targets.empty()) {
+		return;
+	}
+
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	resetSearch();
+
+	// how many times each node is wanted, since targets may repeat.
+	// Targets in other components can't be reached, so the search
+	// doesn't wait for them.
+	unordered_map<int, int> wanted;
+	int home = component(indexOf(pStart));
+	int remaining = 0;
+	for (size_t t = 0; t < targets.size(); t++) {
+		// targets not in the graph are left unreached.
+		if (component(indexOf(targets[t])) == home) {
+			wanted[packedId(targets[t])]++;
+			remaining++;
+		}
+	}
+
+	typedef pair<int, int> Entry;
+	priority_queue<Entry, vector<Entry>, greater<Entry> > pq;
+	int start = packedId(pStart);
+	touch(start, 0, -1);
+	pq.push(Entry(0, start));
+
+	while (!pq.empty() && remaining > 0)
+	{
+		Entry top = pq.top();
+		pq.pop();
+		int u = top.second;
+		// skip entries beaten since they were queued.
+		if (top.first != m_searchCost[u]) {
+			continue;
+		}
+
+		// u is settled: tick it off if it is a target.
+		typename unordered_map<int, int>::iterator found = wanted.find(u);
+		if (found != wanted.end()) {
+			remaining -= found->second;
+			wanted.erase(found);
+		}
+
+		for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+			int v = graph.target(arc);
+			int c = top.first + graph.weight(arc);
+			if (c < m_searchCost[v]) {
+				touch(v, c, u);
+				pq.push(Entry(c, v));
+			}
+		}
+	}
+
+	for (size_t t = 0; t < targets.size(); t++) {
+		if (indexOf(targets[t]) == -1) {
+			continue;
+		}
+		int target = packedId(targets[t]);
+		costs[t] = m_searchCost[target];
+		searchPath(graph, target, paths[t]);
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           UCSRange
+//  Description:    Uniform cost search limited by cost rather than a
+//                  target, for isochrones and service areas. It stops
+//                  as soon as the cheapest queued node is over the
+//                  budget, and only the nodes it touched are reset
+//                  for the next search.
+//  Arguments:      The first parameter is the starting node
+//                  The second parameter is the cost budget.
+//                  The third parameter receives every node within the
+//                  budget and its cost, cheapest first.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::UCSRange(Node* pStart, int budget, vector< pair<Node*, int> >& reached)
+{
+	reached.clear();
+	if (pStart == 0 || budget < 0) {
+		return;
+	}
+
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	resetSearch();
+
+	typedef pair<int, int> Entry;
+	priority_queue<Entry, vector<Entry>, greater<Entry> > pq;
+	int start = packedId(pStart);
+	touch(start, 0, -1);
+	pq.push(Entry(0, start));
+
+	while (!pq.empty() && pq.top().first <= budget)
+	{
+		Entry top = pq.top();
+		pq.pop();
+		int u = top.second;
+		// skip entries beaten since they were queued.
+		if (top.first != m_searchCost[u]) {
+			continue;
+		}
+		reached.push_back(pair<Node*, int>(graph.node(u), top.first));
+
+		for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+			int v = graph.target(arc);
+			int c = top.first + graph.weight(arc);
+			// nothing over budget is worth queueing.
+			if (c <= budget && c < m_searchCost[v]) {
+				touch(v, c, u);
+				pq.push(Entry(c, v));
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           deltaStepping
+//  Description:    Multithreaded single-source shortest paths by
+//                  delta-stepping. Nodes sit in buckets of width delta
+//                  by distance. The lowest bucket is emptied by
+//                  relaxing its light arcs (weight <= delta) in
+//                  parallel until nothing new lands in it, then the
+//                  heavy arcs of everything it held are relaxed once.
+//                  Distances are lowered with an atomic minimum.
+//                  The results are only given back in the arrays;
+//                  like the other searches that answer in arrays, it
+//                  leaves the nodes alone.
+//  Arguments:      The first parameter is the starting node
+//                  The second parameter receives the cost to each node
+//                  by index, INT_MAX if unreachable.
+//                  The third parameter receives the previous node
+//                  index on each shortest path, -1 for none.
+//                  The fourth parameter is the bucket width, or 0 to
+//                  pick one from the arc weights and degrees.
+//                  The fifth parameter is the number of threads, or
+//                  0 for one per core.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::deltaStepping(Node* pStart, vector<int>& dist, vector<int>& prev, ArcType delta, int threads)
+{
+	dist.assign(m_maxNodes, INT_MAX);
+	prev.assign(m_maxNodes, -1);
+	if (pStart == 0) {
+		return;
+	}
+
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	int n = graph.size();
+	int workers = workerCount(threads);
+	const int chunk = 64;
+
+	if (delta <= 0) {
+		// roughly the heaviest arc over the average degree.
+		ArcType heaviest = 0;
+		for (int arc = 0; arc < graph.arcCount(); arc++) {
+			if (graph.weight(arc) > heaviest) {
+				heaviest = graph.weight(arc);
+			}
+		}
+		int degree = m_count > 0 ? graph.arcCount() / m_count : 1;
+		delta = heaviest / (degree > 0 ? degree : 1);
+		if (delta <= 0) {
+			delta = 1;
+		}
+	}
+
+	unique_ptr<atomic<int>[]> cost(new atomic<int>[n]);
+	for (int i = 0; i < n; i++) {
+		cost[i].store(INT_MAX, memory_order_relaxed);
+	}
+
+	// buckets may hold stale entries, skipped when their cost has
+	// since moved to a lower bucket.
+	vector< vector<int> > buckets(1);
+	vector<int> current;
+	vector<int> settled;
+	vector<char> inCurrent(n, 0);
+	vector< vector<int> > found(workers);
+	bool heavy = false;
+	bool done = false;
+	atomic<int> cursor(0);
+	Barrier barrier(workers);
+
+	int start = packedId(pStart);
+	cost[start].store(0, memory_order_relaxed);
+	buckets[0].push_back(start);
+	size_t bucket = 0;
+
+	// sort the nodes found by the last phase into their buckets.
+	auto gather = [&]() {
+		for (int t = 0; t < workers; t++) {
+			for (size_t i = 0; i < found[t].size(); i++) {
+				int v = found[t][i];
+				size_t b = cost[v].load(memory_order_relaxed) / delta;
+				if (b >= buckets.size()) {
+					buckets.resize(b + 1);
+				}
+				buckets[b].push_back(v);
+			}
+			found[t].clear();
+		}
+	};
+
+	// pick the next set of nodes to relax, or finish.
+	auto plan = [&]() {
+		while (true) {
+			while (bucket < buckets.size() && buckets[bucket].empty()) {
+				if (!heavy && !settled.empty()) {
+					// bucket emptied: its heavy arcs go next.
+					current.swap(settled);
+					settled.clear();
+					heavy = true;
+					return;
+				}
+				heavy = false;
+				bucket++;
+			}
+			if (bucket >= buckets.size()) {
+				done = true;
+				return;
+			}
+			heavy = false;
+			current.clear();
+			vector<int> entries;
+			entries.swap(buckets[bucket]);
+			for (size_t i = 0; i < entries.size(); i++) {
+				int v = entries[i];
+				if ((size_t)(cost[v].load(memory_order_relaxed) / delta) == bucket && !inCurrent[v]) {
+					inCurrent[v] = 1;
+					current.push_back(v);
+				}
+			}
+			for (size_t i = 0; i < current.size(); i++) {
+				inCurrent[current[i]] = 0;
+				settled.push_back(current[i]);
+			}
+			if (!current.empty()) {
+				return;
+			}
+		}
+	};
+
+	auto work = [&](int worker) {
+		while (true) {
+			if (worker == 0) {
+				gather();
+				plan();
+				cursor.store(0);
+			}
+			barrier.wait();
+			if (done) {
+				break;
+			}
+
+			int size = (int)current.size();
+			int first;
+			while ((first = cursor.fetch_add(chunk)) < size) {
+				int last = first + chunk < size ? first + chunk : size;
+				for (int i = first; i < last; i++) {
+					int u = current[i];
+					int base = cost[u].load(memory_order_relaxed);
+					for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+						ArcType weight = graph.weight(arc);
+						if ((weight > delta) != heavy) {
+							continue;
+						}
+						int v = graph.target(arc);
+						int c = base + weight;
+						// atomic minimum.
+						int old = cost[v].load(memory_order_relaxed);
+						while (c < old && !cost[v].compare_exchange_weak(old, c)) {
+						}
+						if (c < old) {
+							found[worker].push_back(v);
+						}
+					}
+				}
+			}
+			barrier.wait();
+		}
+	};
+
+	vector<thread> pool;
+	for (int t = 1; t < workers; t++) {
+		pool.push_back(thread(work, t));
+	}
+	work(0);
+	for (size_t t = 0; t < pool.size(); t++) {
+		pool[t].join();
+	}
+
+	for (int i = 0; i < n; i++) {
+		dist[i] = cost[i].load(memory_order_relaxed);
+	}
+
+	// build the tree along tight arcs, breadth first from the start,
+	// so zero weight cycles can't make the previous pointers loop.
+	vector<char> reached(n, 0);
+	vector<int> queue;
+	queue.reserve(n);
+	queue.push_back(start);
+	reached[start] = 1;
+	for (size_t i = 0; i < queue.size(); i++) {
+		int u = queue[i];
+		for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+			int v = graph.target(arc);
+			if (!reached[v] && dist[u] + graph.weight(arc) == dist[v]) {
+				reached[v] = 1;
+				prev[v] = u;
+				queue.push_back(v);
+			}
+		}
+	}
+
+	unpack(dist, false);
+	unpack(prev, true);
+}
+
+// ----------------------------------------------------------------
+//  Name:           strongComponents
+//  Description:    Finds the strongly connected components with
+//                  Tarjan's algorithm, using an explicit stack of
+//                  frames instead of recursion. Components are
+//                  numbered in topological order, so every arc
+//                  between two components goes from a lower number
+//                  to a higher one.
+//  Arguments:      The first parameter receives the component of each
+//                  node, by node index, -1 for empty slots.
+//                  The second parameter optionally receives the
+//                  condensation: for each component, the components
+//                  its arcs lead to, sorted and without repeats.
+//  Return Value:   The number of components.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int Graph<NodeType, ArcType>::strongComponents(vector<int>& component, vector< vector<int> >* pDag)
+{
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	int n = graph.size();
+	component.assign(n, -1);
+
+	// discovery order and the lowest discovery reachable from each node.
+	vector<int> order(n, -1);
+	vector<int> low(n, 0);
+	BitSet onStack(n);
+	vector<int> stack;
+	// each frame is a node and the next arc still to be followed.
+	vector< pair<int, int> > frames;
+	int time = 0;
+	int found = 0;
+
+	for (int root = 0; root < n; root++) {
+		if (graph.node(root) == 0 || order[root] != -1) {
+			continue;
+		}
+		order[root] = low[root] = time++;
+		stack.push_back(root);
+		onStack.set(root);
+		frames.push_back(make_pair(root, graph.firstArc(root)));
+
+		while (!frames.empty()) {
+			int u = frames.back().first;
+			int& arc = frames.back().second;
+			if (arc != graph.endArc(u)) {
+				int v = graph.target(arc);
+				++arc;
+				if (order[v] == -1) {
+					// descend; v's low is folded into u when it returns.
+					order[v] = low[v] = time++;
+					stack.push_back(v);
+					onStack.set(v);
+					frames.push_back(make_pair(v, graph.firstArc(v)));
+				}
+				else if (onStack.test(v) && order[v] < low[u]) {
+					low[u] = order[v];
+				}
+				continue;
+			}
+
+			// u is done: if it roots a component, pop the component.
+			if (low[u] == order[u]) {
+				int v;
+				do {
+					v = stack.back();
+					stack.pop_back();
+					onStack.reset(v);
+					component[v] = found;
+				} while (v != u);
+				found++;
+			}
+			frames.pop_back();
+			if (!frames.empty() && low[u] < low[frames.back().first]) {
+				low[frames.back().first] = low[u];
+			}
+		}
+	}
+
+	// Tarjan finds sinks first, so count down for topological order.
+	for (int i = 0; i < n; i++) {
+		if (component[i] != -1) {
+			component[i] = found - 1 - component[i];
+		}
+	}
+
+	if (pDag != 0) {
+		pDag->assign(found, vector<int>());
+		for (int u = 0; u < n; u++) {
+			for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+				int v = graph.target(arc);
+				if (component[u] != component[v]) {
+					(*pDag)[component[u]].push_back(component[v]);
+				}
+			}
+		}
+		for (int c = 0; c < found; c++) {
+			vector<int>& next = (*pDag)[c];
+			sort(next.begin(), next.end());
+			next.erase(unique(next.begin(), next.end()), next.end());
+		}
+	}
+
+	unpack(component, false);
+	return found;
+}
+
+// ----------------------------------------------------------------
+//  Name:           minimumSpanningForest
+//  Description:    Boruvka's algorithm spread over several threads,
+//                  treating every arc as an undirected edge. Each
+//                  round, the threads scan their share of the edges
+//                  (dropping those now inside one tree) and keep the
+//                  lightest edge leaving each tree with a compare-and-
+//                  swap; those edges then join the trees. Ties go by
+//                  the end indices, so an addDualArc pair is the same
+//                  edge both ways and is taken once.
+//  Arguments:      The first parameter receives the chosen edges as
+//                  (from, to) node index pairs.
+//                  The second parameter is the number of threads, or
+//                  0 for one per core.
+//  Return Value:   The total weight of the forest.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+ArcType Graph<NodeType, ArcType>::minimumSpanningForest(vector< pair<int, int> >& arcs, int threads)
+{
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	int n = graph.size();
+	int m = graph.arcCount();
+	int workers = workerCount(threads);
+	arcs.clear();
+
+	// every arc as an edge with the lower id first.
+	struct Edge {
+		int u;
+		int v;
+		ArcType w;
+	};
+	vector<Edge> edges(m);
+	auto lighter = [&](int a, int b) {
+		Edge const & ea = edges[a];
+		Edge const & eb = edges[b];
+		if (ea.w != eb.w) {
+			return ea.w < eb.w;
+		}
+		return ea.u != eb.u ? ea.u < eb.u : ea.v < eb.v;
+	};
+
+	// the tree each node is in, named by its root, and the
+	// lightest edge leaving each root's tree.
+	vector<int> tree(n);
+	vector<int> label(n);
+	unique_ptr<atomic<int>[]> best(new atomic<int>[n]);
+	DisjointSet trees(n);
+	vector<int> roots;
+	for (int i = 0; i < n; i++) {
+		tree[i] = i;
+		best[i].store(-1, memory_order_relaxed);
+		roots.push_back(i);
+	}
+
+	// each thread owns a slice of the edges, and of the nodes.
+	vector<int> edgeEnd(workers);
+	ArcType total = ArcType();
+	bool done = false;
+	Barrier barrier(workers);
+
+	auto work = [&](int worker) {
+		int firstNode = (int)((long long)n * worker / workers);
+		int lastNode = (int)((long long)n * (worker + 1) / workers);
+		int firstEdge = graph.firstArc(firstNode);
+		int lastEdge = lastNode < n ? graph.firstArc(lastNode) : m;
+		for (int u = firstNode; u < lastNode; u++) {
+			for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+				int v = graph.target(arc);
+				edges[arc].u = u < v ? u : v;
+				edges[arc].v = u < v ? v : u;
+				edges[arc].w = graph.weight(arc);
+			}
+		}
+		edgeEnd[worker] = lastEdge;
+
+		while (true) {
+			// keep only edges between trees, and offer each one to
+			// the trees at both ends.
+			int kept = firstEdge;
+			for (int e = firstEdge; e < edgeEnd[worker]; e++) {
+				int a = tree[edges[e].u];
+				int b = tree[edges[e].v];
+				if (a == b) {
+					continue;
+				}
+				edges[kept] = edges[e];
+				int ends[2] = { a, b };
+				for (int k = 0; k < 2; k++) {
+					// acquire, so the edge another thread offered is seen whole.
+					int seen = best[ends[k]].load(memory_order_acquire);
+					while ((seen == -1 || lighter(kept, seen)) &&
+						!best[ends[k]].compare_exchange_weak(seen, kept)) {
+					}
+				}
+				kept++;
+			}
+			edgeEnd[worker] = kept;
+			barrier.wait();
+
+			if (worker == 0) {
+				// join the trees along their lightest edges.
+				bool joined = false;
+				for (size_t i = 0; i < roots.size(); i++) {
+					int e = best[roots[i]].load(memory_order_relaxed);
+					if (e != -1 && trees.unite(edges[e].u, edges[e].v)) {
+						arcs.push_back(make_pair(edges[e].u, edges[e].v));
+						total += edges[e].w;
+						joined = true;
+					}
+				}
+				vector<int> next;
+				for (size_t i = 0; i < roots.size(); i++) {
+					best[roots[i]].store(-1, memory_order_relaxed);
+					label[roots[i]] = trees.find(roots[i]);
+					if (label[roots[i]] == roots[i]) {
+						next.push_back(roots[i]);
+					}
+				}
+				roots.swap(next);
+				done = !joined;
+			}
+			barrier.wait();
+			if (done) {
+				break;
+			}
+
+			// rename every node's tree to the new root.
+			for (int u = firstNode; u < lastNode; u++) {
+				tree[u] = label[tree[u]];
+			}
+			barrier.wait();
+		}
+	};
+
+	vector<thread> pool;
+	for (int t = 1; t < workers; t++) {
+		pool.push_back(thread(work, t));
+	}
+	work(0);
+	for (size_t t = 0; t < pool.size(); t++) {
+		pool[t].join();
+	}
+
+	for (size_t i = 0; i < arcs.size(); i++) {
+		arcs[i].first = graph.external(arcs[i].first);
+		arcs[i].second = graph.external(arcs[i].second);
+	}
+	return total;
+}
+
+// ----------------------------------------------------------------
+//  Name:           minimumSpanningForestKruskal
+//  Description:    Kruskal's algorithm, one thread: sorts every edge
+//                  and takes each that joins two trees. Ties are
+//                  broken the same way as minimumSpanningForest, so
+//                  both pick the same edges; it is kept to check the
+//                  parallel version against.
+//  Arguments:      The parameter receives the chosen edges as
+//                  (from, to) node index pairs.
+//  Return Value:   The total weight of the forest.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+ArcType Graph<NodeType, ArcType>::minimumSpanningForestKruskal(vector< pair<int, int> >& arcs)
+{
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	int n = graph.size();
+	arcs.clear();
+
+	typedef pair< ArcType, pair<int, int> > Edge;
+	vector<Edge> edges;
+	edges.reserve(graph.arcCount());
+	for (int u = 0; u < n; u++) {
+		for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+			int v = graph.target(arc);
+			if (u != v) {
+				edges.push_back(Edge(graph.weight(arc), make_pair(u < v ? u : v, u < v ? v : u)));
+			}
+		}
+	}
+	sort(edges.begin(), edges.end());
+
+	DisjointSet trees(n);
+	ArcType total = ArcType();
+	for (size_t i = 0; i < edges.size(); i++) {
+		if (trees.unite(edges[i].second.first, edges[i].second.second)) {
+			arcs.push_back(make_pair(graph.external(edges[i].second.first), graph.external(edges[i].second.second)));
+			total += edges[i].first;
+		}
+	}
+	return total;
+}
+
+// ----------------------------------------------------------------
+//  Name:           topologicalOrder
+//  Description:    Orders the nodes so every arc goes forwards, by
+//                  repeatedly taking nodes with no arcs left coming
+//                  in (Kahn's algorithm).
+//  Arguments:      The parameter receives the node indices in order.
+//                  It is left empty if the graph has a cycle.
+//  Return Value:   true if the graph is acyclic.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::topologicalOrder(vector<int>& order)
+{
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	int n = graph.size();
+	order.clear();
+	order.reserve(m_count);
+
+	vector<int> waiting(n);
+	for (int u = 0; u < n; u++) {
+		waiting[u] = graph.endInArc(u) - graph.firstInArc(u);
+		if (graph.node(u) != 0 && waiting[u] == 0) {
+			order.push_back(u);
+		}
+	}
+	// the order doubles as the queue.
+	for (size_t front = 0; front < order.size(); front++) {
+		int u = order[front];
+		for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+			int v = graph.target(arc);
+			if (--waiting[v] == 0) {
+				order.push_back(v);
+			}
+		}
+	}
+
+	// nodes on a cycle never run out of arcs coming in.
+	if ((int)order.size() != m_count) {
+		order.clear();
+		return false;
+	}
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = graph.external(order[i]);
+	}
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           shortestPath
+//  Description:    Finds the cheapest path between two nodes, picking
+//                  the method to suit the graph. If it is acyclic,
+//                  the arcs are relaxed once each in topological
+//                  order, with no priority queue, which is O(V + E)
+//                  and allows negative weights; otherwise UCS is run.
+//                  Acyclicity is checked once per graph version.
+//                  An arc added with addDualArc is a two-node cycle,
+//                  so graphs built that way, like the ones main
+//                  loads, always take the UCS route; only graphs of
+//                  one-way arcs from addArc can be acyclic.
+//                  Either way the path nodes get their cost and
+//                  previous pointer set like UCS, unless the path is
+//                  wanted as a PathResult.
+//  Arguments:      The first parameter is the starting node
+//                  The second parameter is the target node
+//                  The third parameter receives the path, target first.
+//                  It is left empty if the target wasn't reached.
+//                  Given a PathResult instead, it is refilled with the
+//                  path, start first, and the nodes are left alone.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Path>
+void Graph<NodeType, ArcType>::shortestPath(Node* pStart, Node* pTarget, Path& path)
+{
+	// nodes not in the graph, or not joined, have no path.
+	if (!connected(indexOf(pStart), indexOf(pTarget))) {
+		startPath(path);
+		return;
+	}
+	if (m_topoVersion != m_version) {
+		topologicalOrder(m_topoOrder);
+		m_topoPosition.assign(m_maxNodes, -1);
+		for (size_t i = 0; i < m_topoOrder.size(); i++) {
+			m_topoPosition[m_topoOrder[i]] = (int)i;
+		}
+		m_topoVersion = m_version;
+	}
+	if (m_topoOrder.empty()) {
+		UCS(pStart, pTarget, NoVisit(), path);
+		return;
+	}
+
+	CompactGraph<NodeType, ArcType> const & graph = compact();
+	resetSearch();
+	int start = packedId(pStart);
+	int target = packedId(pTarget);
+	touch(start, 0, -1);
+
+	// nothing before the start in the order can be reached, and
+	// nothing after the target can lead back to it.
+	int last = m_topoPosition[indexOf(pTarget)];
+	for (int i = m_topoPosition[indexOf(pStart)]; i <= last; i++) {
+		int u = graph.internal(m_topoOrder[i]);
+		if (m_searchCost[u] == INT_MAX) {
+			continue;
+		}
+		m_searchVisited.set(u);
+		for (int arc = graph.firstArc(u); arc != graph.endArc(u); arc++) {
+			int v = graph.target(arc);
+			int c = m_searchCost[u] + graph.weight(arc);
+			if (c < m_searchCost[v]) {
+				touch(v, c, u);
+			}
+		}
+	}
+
+	searchPath(graph, target, path);
+}
+
 #include "GraphNode.h"
 #include "GraphArc.h"
+#include "CompactGraph.h"
+#include "CompressedGraph.h"
+#include "GraphSnapshot.h"
+#include "TraversalRange.h"
 
 
 #endif
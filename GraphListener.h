@@ -0,0 +1,21 @@
+#ifndef GRAPHLISTENER_H
+#define GRAPHLISTENER_H
+
+// -------------------------------------------------------
+// Name:        GraphListener
+// Description: Something that wants to hear about changes
+//              to a graph's arcs. Register it with
+//              Graph::addListener; it is told about each
+//              arc after the graph has changed.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class GraphListener {
+public:
+    virtual ~GraphListener() {
+    }
+
+    virtual void arcAdded( int from, int to, ArcType weight ) = 0;
+    virtual void arcRemoved( int from, int to, ArcType weight ) = 0;
+};
+
+#endif
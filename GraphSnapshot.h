@@ -0,0 +1,262 @@
+#ifndef GRAPHSNAPSHOT_H
+#define GRAPHSNAPSHOT_H
+
+#include <vector>
+#include <queue>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <climits>
+
+#include "CompactGraph.h"
+#include "PathResult.h"
+
+template <class NodeType, class ArcType> class GraphNode;
+
+// -------------------------------------------------------
+// Name:        SnapshotSearch
+// Description: Search arrays for GraphSnapshot::UCS, kept
+//              by the caller so a thread answering many
+//              queries sizes them once, like Graph's own.
+//              Only the entries a search touched are reset
+//              after it, so a query costs what it explores
+//              rather than O(V). Each thread needs its own.
+// -------------------------------------------------------
+struct SnapshotSearch {
+    // cost and previous packed id by packed id, INT_MAX and -1
+    // between searches.
+    vector<int> cost;
+    vector<int> prev;
+    // the ids given a cost by the search under way.
+    vector<int> touched;
+    // the queue, a binary heap of (cost, packed id).
+    vector< pair<int, int> > heap;
+};
+
+// -------------------------------------------------------
+// Name:        GraphSnapshot
+// Description: An immutable copy of a graph as of one
+//              Graph::publish. Readers pin one with
+//              Graph::snapshot and can search it on any
+//              thread while the writer goes on editing and
+//              searching the graph; nothing they see changes
+//              until they take a newer one. Nodes are named
+//              by their graph index. The node data is copied
+//              in at publish, so readers never touch the
+//              graph's nodes, which the writer's searches
+//              write to. The packed arcs are shared with the
+//              graph rather than copied; the graph copies
+//              them before its next edit instead.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class GraphSnapshot {
+private:
+    typedef GraphNode<NodeType, ArcType> Node;
+
+    shared_ptr< CompactGraph<NodeType, ArcType> const > m_pArcs;
+    unsigned int m_version;
+    int m_count;
+
+// -------------------------------------------------------
+// Description: The data of each node by index, and whether
+//              there is a node there at all.
+// -------------------------------------------------------
+    vector<NodeType> m_data;
+    vector<char> m_present;
+
+public:
+    GraphSnapshot( shared_ptr< CompactGraph<NodeType, ArcType> const > const & pArcs, Node** pNodes, int maxNodes,
+                   unsigned int version, int count );
+
+    // Accessor functions
+    unsigned int version() const {
+        return m_version;
+    }
+
+    int count() const {
+        return m_count;
+    }
+
+    int maxNodes() const {
+        return (int)m_data.size();
+    }
+
+    // the node pointers in the packed arcs belong to the graph and
+    // may be gone; use data() instead.
+    CompactGraph<NodeType, ArcType> const & arcs() const {
+        return *m_pArcs;
+    }
+
+    bool exists( int index ) const {
+        return index >= 0 && index < (int)m_present.size() && m_present[index] != 0;
+    }
+
+    NodeType const & data( int index ) const {
+        return m_data[index];
+    }
+
+    template<class Visitor>
+    void breadthFirst( int start, Visitor visit ) const;
+    int UCS( int start, int target, PathResult& path ) const;
+    int UCS( int start, int target, PathResult& path, SnapshotSearch& search ) const;
+};
+
+// ----------------------------------------------------------------
+//  Name:           GraphSnapshot
+//  Description:    Constructor, copies the data of every node and
+//                  takes a share of the packed arcs. O(V) per
+//                  publish, plus copying whatever the node data
+//                  owns.
+//  Arguments:      The first argument is the graph's packed arcs.
+//                  The second argument is the graph's node array.
+//                  The third argument is the size of that array.
+//                  The fourth and fifth arguments are the graph's
+//                  version and node count.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+GraphSnapshot<NodeType, ArcType>::GraphSnapshot( shared_ptr< CompactGraph<NodeType, ArcType> const > const & pArcs,
+                                                 Node** pNodes, int maxNodes, unsigned int version, int count )
+    : m_pArcs( pArcs ), m_version( version ), m_count( count ), m_data( maxNodes ), m_present( maxNodes, 0 ) {
+    for( int index = 0; index < maxNodes; index++ ) {
+        if( pNodes[index] != 0 ) {
+            m_data[index] = pNodes[index]->data();
+            m_present[index] = 1;
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           breadthFirst
+//  Description:    Breadth-first traversal of the snapshot. The
+//                  search state is its own, so any number of
+//                  threads can traverse one snapshot at once.
+//  Arguments:      The first argument is the starting node index.
+//                  The second argument is the visitor, called with
+//                  each node index in the order reached. VISIT_PRUNE
+//                  skips its arcs, VISIT_STOP ends the traversal.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Visitor>
+void GraphSnapshot<NodeType, ArcType>::breadthFirst( int start, Visitor visit ) const {
+    if( !exists( start ) ) {
+        return;
+    }
+    CompactGraph<NodeType, ArcType> const & graph = *m_pArcs;
+    int id = graph.internal( start );
+    vector<char> seen( graph.size(), 0 );
+    vector<int> queue;
+    queue.push_back( id );
+    seen[id] = 1;
+    for( size_t front = 0; front < queue.size(); front++ ) {
+        int u = queue[front];
+        VisitResult result = callVisitor( visit, graph.external( u ) );
+        if( result == VISIT_STOP ) {
+            return;
+        }
+        if( result == VISIT_PRUNE ) {
+            continue;
+        }
+        for( int arc = graph.firstArc( u ); arc != graph.endArc( u ); arc++ ) {
+            int v = graph.target( arc );
+            if( !seen[v] ) {
+                seen[v] = 1;
+                queue.push_back( v );
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           UCS
+//  Description:    Uniform cost search of the snapshot. Unlike
+//                  Graph::UCS it keeps its state to itself, so any
+//                  number of threads can search one snapshot at once.
+//                  Without search arrays it makes its own, O(V); a
+//                  thread running many searches should pass the same
+//                  ones each time instead.
+//  Arguments:      The first argument is the starting node index.
+//                  The second argument is the target node index.
+//                  The third argument is refilled with the path,
+//                  start first, and left empty if there is none.
+//                  The fourth argument, if given, is the calling
+//                  thread's search arrays.
+//  Return Value:   The cost of the path, or INT_MAX if there is none.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int GraphSnapshot<NodeType, ArcType>::UCS( int start, int target, PathResult& path ) const {
+    SnapshotSearch search;
+    return UCS( start, target, path, search );
+}
+
+template<class NodeType, class ArcType>
+int GraphSnapshot<NodeType, ArcType>::UCS( int start, int target, PathResult& path, SnapshotSearch& search ) const {
+    path.clear();
+    if( !exists( start ) || !exists( target ) ) {
+        return INT_MAX;
+    }
+    CompactGraph<NodeType, ArcType> const & graph = *m_pArcs;
+    if( (int)search.cost.size() != graph.size() ) {
+        search.cost.assign( graph.size(), INT_MAX );
+        search.prev.assign( graph.size(), -1 );
+    }
+    vector<int>& cost = search.cost;
+    vector<int>& prev = search.prev;
+    vector< pair<int, int> >& heap = search.heap;
+    greater< pair<int, int> > later;
+    int from = graph.internal( start );
+    int to = graph.internal( target );
+    cost[from] = 0;
+    search.touched.push_back( from );
+    heap.push_back( make_pair( 0, from ) );
+    while( !heap.empty() ) {
+        pop_heap( heap.begin(), heap.end(), later );
+        pair<int, int> top = heap.back();
+        heap.pop_back();
+        int u = top.second;
+        // a node is only queued again at a lower cost, so the entry
+        // holding its current cost is its only live one.
+        if( top.first != cost[u] ) {
+            continue;
+        }
+        if( u == to ) {
+            break;
+        }
+        for( int arc = graph.firstArc( u ); arc != graph.endArc( u ); arc++ ) {
+            int v = graph.target( arc );
+            int c = top.first + graph.weight( arc );
+            if( c < cost[v] ) {
+                if( cost[v] == INT_MAX ) {
+                    search.touched.push_back( v );
+                }
+                cost[v] = c;
+                prev[v] = u;
+                heap.push_back( make_pair( c, v ) );
+                push_heap( heap.begin(), heap.end(), later );
+            }
+        }
+    }
+
+    int found = cost[to];
+    if( found != INT_MAX ) {
+        for( int id = to; id != -1; id = prev[id] ) {
+            path.nodes.push_back( graph.external( id ) );
+            path.costs.push_back( cost[id] );
+        }
+        reverse( path.nodes.begin(), path.nodes.end() );
+        reverse( path.costs.begin(), path.costs.end() );
+    }
+
+    // leave the arrays clean for the next search.
+    for( size_t i = 0; i < search.touched.size(); i++ ) {
+        cost[search.touched[i]] = INT_MAX;
+        prev[search.touched[i]] = -1;
+    }
+    search.touched.clear();
+    heap.clear();
+    return found;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <string>
+#include <sstream>
+#include <utility>
+
+// ----------------------------------------------------------------
+//  Name:           heapBytes
+//  Description:    Estimates the heap memory a node's data owns
+//                  beyond its own size. Strings short enough to be
+//                  stored inline own nothing; pairs add up both
+//                  halves; anything else is assumed to own nothing.
+//  Arguments:      The value to measure.
+//  Return Value:   The size in bytes.
+// ----------------------------------------------------------------
+template<class T>
+inline unsigned long long heapBytes( T const & ) {
+    return 0;
+}
+
+inline unsigned long long heapBytes( std::string const & text ) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+}
+
+template<class First, class Second>
+inline unsigned long long heapBytes( std::pair<First, Second> const & value ) {
+    return heapBytes( value.first ) + heapBytes( value.second );
+}
+
+// -------------------------------------------------------
+// Name:        MemoryStats
+// Description: What a graph costs in memory, by part, as
+//              given by Graph::memoryStats. Container sizes
+//              are worked out from their capacities and the
+//              usual node layouts, so they are estimates;
+//              allocator overhead isn't counted.
+// -------------------------------------------------------
+struct MemoryStats {
+    // the array of node pointers.
+    unsigned long long nodeArray;
+    // the GraphNode objects themselves.
+    unsigned long long nodes;
+    // heap memory owned by node data, such as long strings.
+    unsigned long long payload;
+    // the std::list entries holding the arcs.
+    unsigned long long arcs;
+    // the node to index map.
+    unsigned long long indices;
+    // the packed copy of the arcs.
+    unsigned long long packed;
+    // the dense search arrays.
+    unsigned long long search;
+    // everything else: component, order and position indexes.
+    unsigned long long auxiliary;
+
+    int nodeCount;
+    int arcCount;
+
+    MemoryStats() : nodeArray( 0 ), nodes( 0 ), payload( 0 ), arcs( 0 ), indices( 0 ),
+                    packed( 0 ), search( 0 ), auxiliary( 0 ), nodeCount( 0 ), arcCount( 0 ) {
+    }
+
+    unsigned long long total() const {
+        return nodeArray + nodes + payload + arcs + indices + packed + search + auxiliary;
+    }
+
+    double perNode() const {
+        return nodeCount > 0 ? (double)total() / nodeCount : 0;
+    }
+
+    double perArc() const {
+        return arcCount > 0 ? (double)total() / arcCount : 0;
+    }
+
+    std::string toJson() const;
+};
+
+// ----------------------------------------------------------------
+//  Name:           toJson
+//  Description:    Writes the figures out as a JSON object.
+//  Arguments:      None.
+//  Return Value:   The JSON text.
+// ----------------------------------------------------------------
+inline std::string MemoryStats::toJson() const {
+    std::ostringstream out;
+    out << "{\"nodeArray\":" << nodeArray
+        << ",\"nodes\":" << nodes
+        << ",\"payload\":" << payload
+        << ",\"arcs\":" << arcs
+        << ",\"indices\":" << indices
+        << ",\"packed\":" << packed
+        << ",\"search\":" << search
+        << ",\"auxiliary\":" << auxiliary
+        << ",\"total\":" << total()
+        << ",\"nodeCount\":" << nodeCount
+        << ",\"arcCount\":" << arcCount
+        << ",\"bytesPerNode\":" << perNode()
+        << ",\"bytesPerArc\":" << perArc()
+        << "}";
+    return out.str();
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef NODEORDER_H
+#define NODEORDER_H
+
+// ----------------------------------------------------------------
+//  Name:           NodeOrder
+//  Description:    How nodes are numbered when a graph is packed.
+//                  Reordering puts nodes that are close in the graph
+//                  close in memory, so searches touch fewer cache
+//                  lines.
+// ----------------------------------------------------------------
+enum NodeOrder {
+    ORDER_INDEX,        // keep the graph's own node indices
+    ORDER_BFS,          // breadth-first from the lowest index node
+    ORDER_RCM,          // reverse Cuthill-McKee
+    ORDER_HILBERT       // along a Hilbert curve through node positions
+};
+
+// ----------------------------------------------------------------
+//  Name:           hilbertIndex
+//  Description:    Finds how far along a Hilbert curve a point on a
+//                  2^16 by 2^16 grid lies.
+//  Arguments:      The x and y grid coordinates.
+//  Return Value:   The distance along the curve.
+// ----------------------------------------------------------------
+inline unsigned long long hilbertIndex( unsigned int x, unsigned int y ) {
+    unsigned long long d = 0;
+    for( unsigned int s = 1u << 15; s > 0; s >>= 1 ) {
+        unsigned int rx = ( x & s ) > 0;
+        unsigned int ry = ( y & s ) > 0;
+        d += (unsigned long long)s * s * ( ( 3 * rx ) ^ ry );
+        // rotate the quadrant so the curve stays continuous.
+        if( ry == 0 ) {
+            if( rx == 1 ) {
+                x = s - 1 - ( x & ( s - 1 ) );
+                y = s - 1 - ( y & ( s - 1 ) );
+            }
+            unsigned int t = x;
+            x = y;
+            y = t;
+        }
+        x &= s - 1;
+        y &= s - 1;
+    }
+    return d;
+}
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef PATHCACHE_H
+#define PATHCACHE_H
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <climits>
+
+#include "Graph.h"
+
+// -------------------------------------------------------
+// Name:        PathCache
+// Description: A bounded least-recently-used cache in
+//              front of Graph::UCS, keyed by the start and
+//              target node indices. Each entry keeps the
+//              path and its costs. The whole cache is
+//              dropped as soon as the graph's version
+//              counter moves on, so it never returns a
+//              route from before a change.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class PathCache {
+private:
+    typedef GraphNode<NodeType, ArcType> Node;
+    typedef unsigned long long Key;
+
+    struct Entry {
+        Key key;
+        // node indices, target first like UCS, and the cost
+        // from the start to each of them.
+        vector<int> path;
+        vector<int> costs;
+    };
+
+    typedef typename list<Entry>::iterator EntryIter;
+
+// -------------------------------------------------------
+// Description: The graph being searched.
+// -------------------------------------------------------
+    Graph<NodeType, ArcType>& m_graph;
+
+// -------------------------------------------------------
+// Description: Entries, most recently used first, and an
+//              index into them by key.
+// -------------------------------------------------------
+    list<Entry> m_entries;
+    unordered_map<Key, EntryIter> m_index;
+
+// -------------------------------------------------------
+// Description: The most entries kept at once.
+// -------------------------------------------------------
+    int m_capacity;
+
+// -------------------------------------------------------
+// Description: The graph version the entries belong to.
+// -------------------------------------------------------
+    unsigned int m_version;
+
+// -------------------------------------------------------
+// Description: Lookup statistics.
+// -------------------------------------------------------
+    long long m_hits;
+    long long m_misses;
+    long long m_invalidations;
+
+public:
+    PathCache( Graph<NodeType, ArcType>& graph, int capacity );
+
+    // Accessor functions
+    int size() const {
+        return (int)m_entries.size();
+    }
+
+    int capacity() const {
+        return m_capacity;
+    }
+
+    long long hits() const {
+        return m_hits;
+    }
+
+    long long misses() const {
+        return m_misses;
+    }
+
+    long long invalidations() const {
+        return m_invalidations;
+    }
+
+    // Manipulator functions
+    void resetStats() {
+        m_hits = 0;
+        m_misses = 0;
+        m_invalidations = 0;
+    }
+
+    void clear();
+    int query( int start, int target, vector<Node*>& path, vector<int>* pCosts = 0 );
+};
+
+// ----------------------------------------------------------------
+//  Name:           PathCache
+//  Description:    Constructor, makes an empty cache.
+//  Arguments:      The first argument is the graph to search.
+//                  The second argument is the most entries to keep.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+PathCache<NodeType, ArcType>::PathCache( Graph<NodeType, ArcType>& graph, int capacity )
+    : m_graph( graph ), m_capacity( capacity > 0 ? capacity : 1 ), m_version( graph.version() ),
+      m_hits( 0 ), m_misses( 0 ), m_invalidations( 0 ) {
+}
+
+// ----------------------------------------------------------------
+//  Name:           clear
+//  Description:    Drops every entry.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void PathCache<NodeType, ArcType>::clear() {
+    m_entries.clear();
+    m_index.clear();
+}
+
+// ----------------------------------------------------------------
+//  Name:           query
+//  Description:    Gets the UCS route between two nodes, from the
+//                  cache when it has it and by running UCS when not.
+//  Arguments:      The first argument is the start node index.
+//                  The second argument is the target node index.
+//                  The third argument receives the path, target first,
+//                  as UCS gives it.
+//                  The fourth argument optionally receives the cost
+//                  from the start to each node on the path, in the
+//                  same order. The nodes' own data is only updated
+//                  when UCS actually runs.
+//  Return Value:   The cost of the path.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int PathCache<NodeType, ArcType>::query( int start, int target, vector<Node*>& path, vector<int>* pCosts ) {
+    Node** pNodes = m_graph.nodeArray();
+
+    // anything cached is stale once the graph has changed.
+    if( m_version != m_graph.version() ) {
+        if( !m_entries.empty() ) {
+            m_invalidations++;
+        }
+        clear();
+        m_version = m_graph.version();
+    }
+
+    Key key = ( (Key)(unsigned int)start << 32 ) | (unsigned int)target;
+    typename unordered_map<Key, EntryIter>::iterator found = m_index.find( key );
+    if( found != m_index.end() ) {
+        m_hits++;
+        // move it to the front as the most recently used.
+        m_entries.splice( m_entries.begin(), m_entries, found->second );
+        Entry const & entry = *found->second;
+        for( size_t i = 0; i < entry.path.size(); i++ ) {
+            path.push_back( pNodes[entry.path[i]] );
+        }
+        if( pCosts != 0 ) {
+            pCosts->assign( entry.costs.begin(), entry.costs.end() );
+        }
+        return entry.costs.empty() ? INT_MAX : entry.costs.front();
+    }
+
+    m_misses++;
+    size_t first = path.size();
+    m_graph.UCS( pNodes[start], pNodes[target], NoVisit(), path );
+
+    Entry entry;
+    entry.key = key;
+    for( size_t i = first; i < path.size(); i++ ) {
+        entry.path.push_back( m_graph.indexOf( path[i] ) );
+        entry.costs.push_back( path[i]->data().second );
+    }
+    if( pCosts != 0 ) {
+        pCosts->assign( entry.costs.begin(), entry.costs.end() );
+    }
+
+    // make room by dropping the least recently used entry.
+    if( (int)m_entries.size() >= m_capacity ) {
+        m_index.erase( m_entries.back().key );
+        m_entries.pop_back();
+    }
+    m_entries.push_front( entry );
+    m_index[key] = m_entries.begin();
+
+    return entry.costs.empty() ? INT_MAX : entry.costs.front();
+}
+
+#endif
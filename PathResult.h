@@ -0,0 +1,39 @@
+#ifndef PATHRESULT_H
+#define PATHRESULT_H
+
+#include <vector>
+#include <climits>
+
+// -------------------------------------------------------
+// Name:        PathResult
+// Description: A path found by a search, start first: the
+//              node index of each step and the cost from
+//              the start to it. Searches clear it and fill
+//              it again, keeping the capacity, so reusing
+//              one result for many searches allocates
+//              nothing once it has grown to the longest.
+// -------------------------------------------------------
+struct PathResult {
+    std::vector<int> nodes;
+    std::vector<int> costs;
+
+    bool empty() const {
+        return nodes.empty();
+    }
+
+    int size() const {
+        return (int)nodes.size();
+    }
+
+    // the cost of the whole path, INT_MAX if there is none.
+    int cost() const {
+        return costs.empty() ? INT_MAX : costs.back();
+    }
+
+    void clear() {
+        nodes.clear();
+        costs.clear();
+    }
+};
+
+#endif
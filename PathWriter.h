@@ -0,0 +1,183 @@
+#ifndef PATHWRITER_H
+#define PATHWRITER_H
+
+#include <ostream>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+#include "PathResult.h"
+
+// ----------------------------------------------------------------
+//  Name:           appendNumber
+//  Description:    Writes a number to a sink in decimal, without
+//                  going through a string.
+//  Arguments:      The first argument is the sink, anything with an
+//                  append( char const*, size_t ), std::string included.
+//                  The second argument is the number.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class Sink>
+void appendNumber( Sink& sink, int value ) {
+    char digits[12];
+    int start = sizeof( digits );
+    // work in unsigned so the most negative int has a magnitude.
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[--start] = (char)( '0' + magnitude % 10 );
+        magnitude /= 10;
+    } while( magnitude != 0 );
+    if( value < 0 ) {
+        digits[--start] = '-';
+    }
+    sink.append( digits + start, sizeof( digits ) - start );
+}
+
+// ----------------------------------------------------------------
+//  Name:           appendPath
+//  Description:    Writes a path to a sink the way main always has:
+//                  the end nodes and total cost, then each node with
+//                  the cost of the arc into it. The one format every
+//                  path printer shares. An empty path writes nothing.
+//  Arguments:      The first argument is the sink, as appendNumber.
+//                  The second argument is the path.
+//                  The third argument gives the name of a node index
+//                  as a std::string.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class Sink, class NameOf>
+void appendPath( Sink& sink, PathResult const & path, NameOf nameOf ) {
+    if( path.empty() ) {
+        return;
+    }
+    std::string const & first = nameOf( path.nodes.front() );
+    std::string const & last = nameOf( path.nodes.back() );
+    sink.append( "=====PP\n[", 9 );
+    sink.append( first.data(), first.size() );
+    sink.append( "-", 1 );
+    sink.append( last.data(), last.size() );
+    sink.append( "] [", 3 );
+    appendNumber( sink, path.cost() );
+    sink.append( "]\n", 2 );
+    int before = 0;
+    for( int i = 0; i < path.size(); i++ ) {
+        if( i > 0 ) {
+            sink.append( "->", 2 );
+        }
+        std::string const & name = nameOf( path.nodes[i] );
+        sink.append( name.data(), name.size() );
+        sink.append( "(", 1 );
+        appendNumber( sink, path.costs[i] - before );
+        sink.append( ")", 1 );
+        before = path.costs[i];
+    }
+    sink.append( "\n=====\n\n", 8 );
+}
+
+// -------------------------------------------------------
+// Name:        PathWriter
+// Description: Prints paths the way main always has, the
+//              end nodes and total cost and then each node
+//              with the cost of the arc into it, into one
+//              fixed buffer that goes to the stream only
+//              when it fills or is flushed. Nothing is
+//              allocated or flushed per path, so thousands
+//              of paths cost little more than their bytes.
+//              Node names are the first half of each node's
+//              data, looked up by index in the graph. The
+//              format is appendPath's.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class PathWriter {
+private:
+    typedef GraphNode<NodeType, ArcType> Node;
+
+    Graph<NodeType, ArcType> const & m_graph;
+    std::ostream& m_out;
+
+// -------------------------------------------------------
+// Description: Text waiting to go out, and how much of
+//              the buffer it fills.
+// -------------------------------------------------------
+    std::vector<char> m_buffer;
+    size_t m_used;
+
+public:
+    PathWriter( Graph<NodeType, ArcType> const & graph, std::ostream& out, size_t bufferSize = 1 << 16 )
+        : m_graph( graph ), m_out( out ), m_buffer( bufferSize > 0 ? bufferSize : 1 ), m_used( 0 ) {
+    }
+
+    ~PathWriter() {
+        flush();
+    }
+
+    void append( char const* pText, size_t size );
+    void write( PathResult const & path );
+    void write( char const* pText );
+    void flush();
+};
+
+// ----------------------------------------------------------------
+//  Name:           append
+//  Description:    Copies text into the buffer, sending the buffer
+//                  on each time it fills.
+//  Arguments:      The text and its length.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void PathWriter<NodeType, ArcType>::append( char const* pText, size_t size ) {
+    while( size > 0 ) {
+        if( m_used == m_buffer.size() ) {
+            m_out.write( m_buffer.data(), (std::streamsize)m_used );
+            m_used = 0;
+        }
+        size_t room = m_buffer.size() - m_used;
+        size_t part = size < room ? size : room;
+        memcpy( m_buffer.data() + m_used, pText, part );
+        m_used += part;
+        pText += part;
+        size -= part;
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           write
+//  Description:    Writes one path. An empty path writes nothing.
+//  Arguments:      The path.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void PathWriter<NodeType, ArcType>::write( PathResult const & path ) {
+    Node** pNodes = m_graph.nodeArray();
+    appendPath( *this, path, [pNodes]( int index ) -> std::string const & { return pNodes[index]->data().first; } );
+}
+
+// ----------------------------------------------------------------
+//  Name:           write
+//  Description:    Writes plain text, in order with the paths.
+//  Arguments:      The text.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void PathWriter<NodeType, ArcType>::write( char const* pText ) {
+    append( pText, strlen( pText ) );
+}
+
+// ----------------------------------------------------------------
+//  Name:           flush
+//  Description:    Sends whatever is buffered to the stream and
+//                  flushes the stream.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void PathWriter<NodeType, ArcType>::flush() {
+    if( m_used > 0 ) {
+        m_out.write( m_buffer.data(), (std::streamsize)m_used );
+        m_used = 0;
+    }
+    m_out.flush();
+}
+
+#endif
@@ -0,0 +1,702 @@
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "Graph.h"
+#include "PathWriter.h"
+
+// ----------------------------------------------------------------
+//  Name:           QueryRequest
+//  Description:    One route query on the wire: a tag the client
+//                  picks to match up the reply, and the start and
+//                  target node indices. Fields are in host byte
+//                  order, since the socket is local.
+// ----------------------------------------------------------------
+struct QueryRequest {
+    uint32_t tag;
+    int32_t from;
+    int32_t to;
+};
+
+// ----------------------------------------------------------------
+//  Name:           QueryReply
+//  Description:    The head of a reply: the request's tag, the path
+//                  cost (-1 if there is no route) and the length of
+//                  the text that follows, which is the path in the
+//                  form appendPath writes (empty if no route).
+// ----------------------------------------------------------------
+struct QueryReply {
+    uint32_t tag;
+    int32_t cost;
+    uint32_t length;
+};
+
+// ----------------------------------------------------------------
+//  Name:           writeFully
+//  Description:    Writes all of a buffer to a socket, carrying on
+//                  after short writes and interrupts.
+//  Arguments:      The socket, the bytes and how many there are.
+//  Return Value:   false if the socket failed or was closed.
+// ----------------------------------------------------------------
+inline bool writeFully( int fd, char const* pBytes, size_t size ) {
+    while( size > 0 ) {
+        ssize_t sent = send( fd, pBytes, size, MSG_NOSIGNAL );
+        if( sent < 0 && errno == EINTR ) {
+            continue;
+        }
+        if( sent <= 0 ) {
+            return false;
+        }
+        pBytes += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           readFully
+//  Description:    Reads an exact number of bytes from a socket.
+//  Arguments:      The socket, where to put the bytes and how many.
+//  Return Value:   false if the socket failed or closed first.
+// ----------------------------------------------------------------
+inline bool readFully( int fd, char* pBytes, size_t size ) {
+    while( size > 0 ) {
+        ssize_t got = recv( fd, pBytes, size, 0 );
+        if( got < 0 && errno == EINTR ) {
+            continue;
+        }
+        if( got <= 0 ) {
+            return false;
+        }
+        pBytes += got;
+        size -= (size_t)got;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           connectQueryServer
+//  Description:    Opens a connection to a QueryServer.
+//  Arguments:      The path of the server's socket.
+//  Return Value:   The socket, or -1 on failure.
+// ----------------------------------------------------------------
+inline int connectQueryServer( std::string const & path ) {
+    sockaddr_un address;
+    memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+    if( path.size() >= sizeof( address.sun_path ) ) {
+        return -1;
+    }
+    strcpy( address.sun_path, path.c_str() );
+    int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( fd < 0 ) {
+        return -1;
+    }
+    if( connect( fd, (sockaddr*)&address, sizeof( address ) ) != 0 ) {
+        close( fd );
+        return -1;
+    }
+    return fd;
+}
+
+// ----------------------------------------------------------------
+//  Name:           askQueryServer
+//  Description:    Sends a batch of route queries down one connection
+//                  and waits for every reply. The requests go out in
+//                  one write, so the server can spread them over its
+//                  workers; replies may come back in any order.
+//  Arguments:      The first argument is the connected socket.
+//                  The second argument is the start and target index
+//                  of each route.
+//                  The third argument receives each route's cost, -1
+//                  if there is no route.
+//                  The fourth argument receives each route's text.
+//  Return Value:   false if the connection failed.
+// ----------------------------------------------------------------
+inline bool askQueryServer( int fd, std::vector< std::pair<int, int> > const & routes,
+                            std::vector<int>& costs, std::vector<std::string>& texts ) {
+    std::vector<QueryRequest> requests( routes.size() );
+    for( size_t i = 0; i < routes.size(); i++ ) {
+        requests[i].tag = (uint32_t)i;
+        requests[i].from = routes[i].first;
+        requests[i].to = routes[i].second;
+    }
+    if( !writeFully( fd, (char const*)requests.data(), requests.size() * sizeof( QueryRequest ) ) ) {
+        return false;
+    }
+    costs.assign( routes.size(), -1 );
+    texts.assign( routes.size(), std::string() );
+    for( size_t i = 0; i < routes.size(); i++ ) {
+        QueryReply reply;
+        if( !readFully( fd, (char*)&reply, sizeof( reply ) ) || reply.tag >= routes.size() ) {
+            return false;
+        }
+        std::string& text = texts[reply.tag];
+        text.resize( reply.length );
+        if( reply.length > 0 && !readFully( fd, &text[0], reply.length ) ) {
+            return false;
+        }
+        costs[reply.tag] = reply.cost;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           setNonBlocking
+//  Description:    Makes reads and writes on a descriptor fail with
+//                  EAGAIN rather than wait.
+//  Arguments:      The descriptor.
+//  Return Value:   false if it couldn't be changed.
+// ----------------------------------------------------------------
+inline bool setNonBlocking( int fd ) {
+    int flags = fcntl( fd, F_GETFL, 0 );
+    return flags >= 0 && fcntl( fd, F_SETFL, flags | O_NONBLOCK ) == 0;
+}
+
+// -------------------------------------------------------
+// Name:        QueryServer
+// Description: Answers route queries for a graph held in
+//              memory, over a Unix domain socket, so clients
+//              don't pay to load the graph per query. One
+//              thread reads requests off every connection
+//              into a shared queue; worker threads each take
+//              a batch at a time, search one pinned snapshot
+//              of the graph for all of them and hand the
+//              replies back to the reader thread, which sends
+//              them as each client's socket has room. The
+//              graph's owner can go on editing it and calling
+//              Graph::publish meanwhile. Node data must be a
+//              (name, cost) pair, as the paths are printed
+//              by name.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class QueryServer {
+private:
+    typedef GraphNode<NodeType, ArcType> Node;
+
+// -------------------------------------------------------
+// Description: A client connection. The socket is non-
+//              blocking and only the reader thread uses it;
+//              workers leave their replies in the output
+//              buffer, so a client that stops reading holds
+//              up no one but itself. Once the client has
+//              gone its replies are dropped instead, and the
+//              socket is closed when nothing holds the
+//              connection any more.
+// -------------------------------------------------------
+    struct Connection {
+        int fd;
+        // bytes read that don't make up a whole request yet.
+        std::string pending;
+
+        std::mutex outputLock;
+        std::string output;
+        bool closed;
+
+        explicit Connection( int socket ) : fd( socket ), closed( false ) {
+        }
+
+        ~Connection() {
+            close( fd );
+        }
+    };
+
+    struct Query {
+        std::shared_ptr<Connection> pConnection;
+        QueryRequest request;
+    };
+
+    Graph<NodeType, ArcType>& m_graph;
+    std::string m_path;
+    int m_threads;
+    int m_batch;
+
+// -------------------------------------------------------
+// Description: The listening socket, and a pipe that wakes
+//              the reader thread up when there are replies
+//              to send or it is time to stop.
+// -------------------------------------------------------
+    int m_listenFd;
+    int m_wake[2];
+    std::atomic<bool> m_closing;
+
+// -------------------------------------------------------
+// Description: Queries waiting for a worker.
+// -------------------------------------------------------
+    std::deque<Query> m_queue;
+    std::mutex m_queueLock;
+    std::condition_variable m_queued;
+    bool m_stopping;
+
+    std::thread m_reader;
+    std::vector<std::thread> m_workers;
+
+// -------------------------------------------------------
+// Description: Queries answered and batches taken so far.
+// -------------------------------------------------------
+    std::atomic<long long> m_answered;
+    std::atomic<long long> m_batches;
+
+    void receive();
+    int readRequests( std::shared_ptr<Connection> const & pConnection, bool& open );
+    bool sendReplies( Connection& connection );
+    void drop( std::shared_ptr<Connection> const & pConnection );
+    void wake();
+    void work();
+    void answer( GraphSnapshot<NodeType, ArcType> const & snapshot, QueryRequest const & request, std::string& out,
+                 SnapshotSearch& search );
+
+public:
+    QueryServer( Graph<NodeType, ArcType>& graph, std::string const & path, int threads = 0, int batch = 64 );
+    ~QueryServer();
+
+    // Accessor functions
+    long long answered() const {
+        return m_answered.load();
+    }
+
+    long long batches() const {
+        return m_batches.load();
+    }
+
+    bool start();
+    void stop();
+};
+
+// ----------------------------------------------------------------
+//  Name:           QueryServer
+//  Description:    Constructor. Nothing is opened until start.
+//  Arguments:      The first argument is the graph to answer for.
+//                  The second argument is the path of the socket.
+//                  The third argument is the number of workers, 0
+//                  for one per core.
+//                  The fourth argument is the most queries a worker
+//                  takes at once.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+QueryServer<NodeType, ArcType>::QueryServer( Graph<NodeType, ArcType>& graph, std::string const & path, int threads, int batch )
+    : m_graph( graph ), m_path( path ), m_threads( workerCount( threads ) ), m_batch( batch > 0 ? batch : 1 ),
+      m_listenFd( -1 ), m_closing( false ), m_stopping( false ), m_answered( 0 ), m_batches( 0 ) {
+    m_wake[0] = -1;
+    m_wake[1] = -1;
+}
+
+// ----------------------------------------------------------------
+//  Name:           ~QueryServer
+//  Description:    Destructor, stops the server if it is running.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+QueryServer<NodeType, ArcType>::~QueryServer() {
+    stop();
+}
+
+// ----------------------------------------------------------------
+//  Name:           start
+//  Description:    Opens the socket, replacing any file left at its
+//                  path, and starts the reader and worker threads.
+//                  The graph is published first if it never has been.
+//  Arguments:      None.
+//  Return Value:   false if the socket couldn't be opened.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool QueryServer<NodeType, ArcType>::start() {
+    sockaddr_un address;
+    memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+    if( m_listenFd >= 0 || m_path.size() >= sizeof( address.sun_path ) ) {
+        return false;
+    }
+    strcpy( address.sun_path, m_path.c_str() );
+
+    m_listenFd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( m_listenFd < 0 ) {
+        return false;
+    }
+    unlink( m_path.c_str() );
+    if( bind( m_listenFd, (sockaddr*)&address, sizeof( address ) ) != 0 || listen( m_listenFd, 64 ) != 0 ||
+        !setNonBlocking( m_listenFd ) ) {
+        close( m_listenFd );
+        m_listenFd = -1;
+        return false;
+    }
+    // the pipe never blocks either: a worker with a full pipe
+    // knows the reader has wake-ups enough waiting.
+    if( pipe( m_wake ) != 0 ) {
+        close( m_listenFd );
+        m_listenFd = -1;
+        return false;
+    }
+    setNonBlocking( m_wake[0] );
+    setNonBlocking( m_wake[1] );
+
+    if( !m_graph.snapshot() ) {
+        m_graph.publish();
+    }
+    m_stopping = false;
+    m_closing = false;
+    for( int i = 0; i < m_threads; i++ ) {
+        m_workers.push_back( std::thread( [this] { work(); } ) );
+    }
+    m_reader = std::thread( [this] { receive(); } );
+    return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           stop
+//  Description:    Lets the workers finish the queries already
+//                  queued, taking no more, then gives the clients a
+//                  second to read their replies and closes the
+//                  socket and every connection.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void QueryServer<NodeType, ArcType>::stop() {
+    if( m_listenFd < 0 ) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_queueLock );
+        m_stopping = true;
+    }
+    m_queued.notify_all();
+    for( size_t i = 0; i < m_workers.size(); i++ ) {
+        m_workers[i].join();
+    }
+    m_workers.clear();
+    m_closing = true;
+    wake();
+    m_reader.join();
+    close( m_wake[0] );
+    close( m_wake[1] );
+    close( m_listenFd );
+    m_listenFd = -1;
+    unlink( m_path.c_str() );
+}
+
+// ----------------------------------------------------------------
+//  Name:           wake
+//  Description:    Wakes the reader thread, to send replies or stop.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void QueryServer<NodeType, ArcType>::wake() {
+    char byte = 0;
+    while( write( m_wake[1], &byte, 1 ) < 0 && errno == EINTR ) {
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           receive
+//  Description:    The reader thread. Waits on the listening socket
+//                  and every connection at once, accepts clients,
+//                  queues each whole request as it arrives, and
+//                  sends replies as the sockets take them. Once
+//                  stopping it only sends, until every reply has
+//                  gone or the clients have read nothing for a
+//                  second.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void QueryServer<NodeType, ArcType>::receive() {
+    std::vector< std::shared_ptr<Connection> > connections;
+    std::vector<pollfd> waits;
+    char drain[64];
+
+    for( ;; ) {
+        bool closing = m_closing.load();
+        short reading = closing ? 0 : POLLIN;
+
+        // the wake pipe and the listening socket come first.
+        waits.resize( connections.size() + 2 );
+        waits[0].fd = m_wake[0];
+        waits[0].events = POLLIN;
+        waits[1].fd = m_listenFd;
+        waits[1].events = reading;
+        bool sending = false;
+        for( size_t i = 0; i < connections.size(); i++ ) {
+            waits[i + 2].fd = connections[i]->fd;
+            waits[i + 2].events = reading;
+            std::lock_guard<std::mutex> lock( connections[i]->outputLock );
+            if( !connections[i]->output.empty() ) {
+                waits[i + 2].events |= POLLOUT;
+                sending = true;
+            }
+        }
+        if( closing && !sending ) {
+            break;
+        }
+        for( size_t i = 0; i < waits.size(); i++ ) {
+            waits[i].revents = 0;
+        }
+        int ready = poll( waits.data(), waits.size(), closing ? 1000 : -1 );
+        if( ready < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            break;
+        }
+        if( ready == 0 ) {
+            break;
+        }
+        if( waits[0].revents != 0 ) {
+            while( read( m_wake[0], drain, sizeof( drain ) ) > 0 ) {
+            }
+        }
+
+        // serve the connections before accepting, while the wait
+        // list still lines up with them.
+        int queued = 0;
+        for( size_t i = connections.size(); i-- > 0; ) {
+            short events = waits[i + 2].revents;
+            if( events == 0 ) {
+                continue;
+            }
+            std::shared_ptr<Connection> pConnection = connections[i];
+            bool open = true;
+            if( ( events & POLLOUT ) != 0 ) {
+                open = sendReplies( *pConnection );
+            }
+            if( open && ( events & ~POLLOUT ) != 0 ) {
+                queued += readRequests( pConnection, open );
+            }
+            if( !open ) {
+                drop( pConnection );
+                connections.erase( connections.begin() + i );
+            }
+        }
+        if( queued == 1 ) {
+            m_queued.notify_one();
+        }
+        else if( queued > 1 ) {
+            m_queued.notify_all();
+        }
+
+        if( waits[1].revents != 0 ) {
+            int fd = accept( m_listenFd, 0, 0 );
+            if( fd >= 0 ) {
+                if( setNonBlocking( fd ) ) {
+                    connections.push_back( std::shared_ptr<Connection>( new Connection( fd ) ) );
+                }
+                else {
+                    close( fd );
+                }
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           readRequests
+//  Description:    Reads what a connection has waiting and queues
+//                  each whole request in it. Once stopping, the
+//                  requests are read but dropped.
+//  Arguments:      The first argument is the connection.
+//                  The second argument is cleared if the client has
+//                  closed it or it failed.
+//  Return Value:   The number of queries queued.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int QueryServer<NodeType, ArcType>::readRequests( std::shared_ptr<Connection> const & pConnection, bool& open ) {
+    char buffer[4096];
+    ssize_t got = recv( pConnection->fd, buffer, sizeof( buffer ), 0 );
+    if( got < 0 ) {
+        open = errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+        return 0;
+    }
+    if( got == 0 ) {
+        open = false;
+        return 0;
+    }
+    std::string& pending = pConnection->pending;
+    pending.append( buffer, (size_t)got );
+    size_t whole = pending.size() / sizeof( QueryRequest );
+    if( whole == 0 ) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock( m_queueLock );
+    if( !m_stopping ) {
+        for( size_t r = 0; r < whole; r++ ) {
+            Query query;
+            query.pConnection = pConnection;
+            memcpy( &query.request, pending.data() + r * sizeof( QueryRequest ), sizeof( QueryRequest ) );
+            m_queue.push_back( query );
+        }
+    }
+    pending.erase( 0, whole * sizeof( QueryRequest ) );
+    return m_stopping ? 0 : (int)whole;
+}
+
+// ----------------------------------------------------------------
+//  Name:           sendReplies
+//  Description:    Sends as much of a connection's waiting replies
+//                  as its socket will take without blocking.
+//  Arguments:      The connection.
+//  Return Value:   false if the client has closed it or it failed.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool QueryServer<NodeType, ArcType>::sendReplies( Connection& connection ) {
+    std::lock_guard<std::mutex> lock( connection.outputLock );
+    std::string& output = connection.output;
+    size_t done = 0;
+    while( done < output.size() ) {
+        ssize_t sent = send( connection.fd, output.data() + done, output.size() - done, MSG_NOSIGNAL );
+        if( sent < 0 && errno == EINTR ) {
+            continue;
+        }
+        if( sent < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+            break;
+        }
+        if( sent <= 0 ) {
+            return false;
+        }
+        done += (size_t)sent;
+    }
+    output.erase( 0, done );
+    return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           drop
+//  Description:    Forgets a connection the client has closed: its
+//                  unsent replies, the queries of its still queued,
+//                  and any replies the workers finish for it later.
+//  Arguments:      The connection.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void QueryServer<NodeType, ArcType>::drop( std::shared_ptr<Connection> const & pConnection ) {
+    {
+        std::lock_guard<std::mutex> lock( pConnection->outputLock );
+        pConnection->closed = true;
+        std::string().swap( pConnection->output );
+    }
+    std::lock_guard<std::mutex> lock( m_queueLock );
+    Connection* pGone = pConnection.get();
+    m_queue.erase( std::remove_if( m_queue.begin(), m_queue.end(),
+                                   [pGone]( Query const & query ) { return query.pConnection.get() == pGone; } ),
+                   m_queue.end() );
+}
+
+// ----------------------------------------------------------------
+//  Name:           work
+//  Description:    A worker thread. Takes up to a batch of queries,
+//                  answers them all from one snapshot, and adds each
+//                  connection's replies to its output in one go for
+//                  the reader thread to send. Runs until stopped and
+//                  the queue is empty.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void QueryServer<NodeType, ArcType>::work() {
+    std::vector<Query> batch;
+    std::vector< std::pair<Connection*, std::string> > replies;
+    // sized on the first search and reused for every one after.
+    SnapshotSearch search;
+    for( ;; ) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock( m_queueLock );
+            while( m_queue.empty() && !m_stopping ) {
+                m_queued.wait( lock );
+            }
+            if( m_queue.empty() ) {
+                return;
+            }
+            while( !m_queue.empty() && (int)batch.size() < m_batch ) {
+                batch.push_back( m_queue.front() );
+                m_queue.pop_front();
+            }
+        }
+
+        std::shared_ptr< GraphSnapshot<NodeType, ArcType> const > pSnapshot = m_graph.snapshot();
+        replies.clear();
+        for( size_t i = 0; i < batch.size(); i++ ) {
+            Connection* pConnection = batch[i].pConnection.get();
+            size_t r = 0;
+            while( r < replies.size() && replies[r].first != pConnection ) {
+                r++;
+            }
+            if( r == replies.size() ) {
+                replies.push_back( std::make_pair( pConnection, std::string() ) );
+            }
+            answer( *pSnapshot, batch[i].request, replies[r].second, search );
+        }
+        bool sending = false;
+        for( size_t r = 0; r < replies.size(); r++ ) {
+            Connection& connection = *replies[r].first;
+            std::lock_guard<std::mutex> lock( connection.outputLock );
+            if( connection.closed ) {
+                continue;
+            }
+            // the reader only needs waking for a connection it
+            // isn't already waiting to send to.
+            sending = sending || connection.output.empty();
+            connection.output.append( replies[r].second );
+        }
+        if( sending ) {
+            wake();
+        }
+        m_answered += (long long)batch.size();
+        m_batches++;
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           answer
+//  Description:    Searches a snapshot for one query and appends the
+//                  reply, head and text, to a buffer.
+//  Arguments:      The snapshot, the query, the reply buffer and the
+//                  worker's search arrays.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void QueryServer<NodeType, ArcType>::answer( GraphSnapshot<NodeType, ArcType> const & snapshot, QueryRequest const & request,
+                                             std::string& out, SnapshotSearch& search ) {
+    QueryReply reply;
+    reply.tag = request.tag;
+    reply.cost = -1;
+    reply.length = 0;
+
+    // the text goes straight after the head, which is filled in
+    // once its length is known.
+    size_t head = out.size();
+    out.append( (char const*)&reply, sizeof( reply ) );
+    if( request.from >= 0 && request.from < snapshot.maxNodes() && request.to >= 0 && request.to < snapshot.maxNodes() ) {
+        PathResult path;
+        int cost = snapshot.UCS( request.from, request.to, path, search );
+        if( cost != INT_MAX ) {
+            appendPath( out, path, [&snapshot]( int index ) -> std::string const & { return snapshot.data( index ).first; } );
+            reply.cost = cost;
+            reply.length = (uint32_t)( out.size() - head - sizeof( reply ) );
+            memcpy( &out[head], &reply, sizeof( reply ) );
+        }
+    }
+}
+
+#endif
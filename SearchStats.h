@@ -0,0 +1,58 @@
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+// -------------------------------------------------------
+// Name:        SearchStats
+// Description: How much work one search did. Give it to
+//              Graph::setSearchStats and each search clears
+//              it and counts into it. Counting is compiled
+//              in only when GRAPH_SEARCH_STATS is defined,
+//              so normal builds pay nothing for it.
+// -------------------------------------------------------
+struct SearchStats {
+    // nodes whose cost or place in the order became final.
+    long long settled;
+    // arcs looked at.
+    long long scanned;
+    // arcs that lowered a node's cost or first reached it.
+    long long relaxed;
+    // queue or stack operations, and the most held at once.
+    long long pushes;
+    long long pops;
+    long long maxQueue;
+
+    SearchStats() {
+        clear();
+    }
+
+    void clear() {
+        settled = 0;
+        scanned = 0;
+        relaxed = 0;
+        pushes = 0;
+        pops = 0;
+        maxQueue = 0;
+    }
+
+    void queued( long long size ) {
+        if( size > maxQueue ) {
+            maxQueue = size;
+        }
+    }
+};
+
+// ----------------------------------------------------------------
+//  Name:           SEARCH_STAT
+//  Description:    Runs a statement on the graph's SearchStats, if
+//                  it has one, inside Graph members; nothing at all
+//                  unless GRAPH_SEARCH_STATS is defined.
+//  Arguments:      The member call or counter to bump, for example
+//                  SEARCH_STAT( pops++ ).
+// ----------------------------------------------------------------
+#ifdef GRAPH_SEARCH_STATS
+#define SEARCH_STAT( statement ) do { if( m_pStats != 0 ) { m_pStats->statement; } } while( 0 )
+#else
+#define SEARCH_STAT( statement ) do { } while( 0 )
+#endif
+
+#endif
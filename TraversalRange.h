@@ -0,0 +1,259 @@
+#ifndef TRAVERSALRANGE_H
+#define TRAVERSALRANGE_H
+
+#include <vector>
+#include <deque>
+#include <utility>
+#include <iterator>
+#include <memory>
+
+#include "BitSet.h"
+#include "CompactGraph.h"
+
+template <class NodeType, class ArcType> class GraphNode;
+
+// -------------------------------------------------------
+// Name:        TraversalIterator
+// Description: An input iterator over a traversal range,
+//              for range-based for loops and the standard
+//              algorithms. Stepping it steps the range, so
+//              all iterators of one range move together.
+// -------------------------------------------------------
+template<class Range, class Node>
+class TraversalIterator {
+private:
+    Range* m_pRange;
+
+public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef Node* value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Node* const * pointer;
+    typedef Node* reference;
+
+    explicit TraversalIterator( Range* pRange = 0 ) : m_pRange( pRange ) {
+    }
+
+    Node* operator*() const {
+        return m_pRange->front();
+    }
+
+    TraversalIterator& operator++() {
+        m_pRange->next();
+        return *this;
+    }
+
+    void operator++( int ) {
+        m_pRange->next();
+    }
+
+    // iterators are equal once both are at the end.
+    bool operator==( TraversalIterator const & other ) const {
+        bool end = m_pRange == 0 || m_pRange->empty();
+        bool otherEnd = other.m_pRange == 0 || other.m_pRange->empty();
+        return end && otherEnd;
+    }
+
+    bool operator!=( TraversalIterator const & other ) const {
+        return !( *this == other );
+    }
+};
+
+// -------------------------------------------------------
+// Name:        BreadthFirstRange
+// Description: A breadth-first traversal that hands out
+//              its nodes one at a time, on request, in the
+//              order breadthFirst visits them. A node's arcs
+//              are only followed when the range moves past
+//              it, so stopping early does no extra work and
+//              prune() can still skip them. It keeps its own
+//              queue and O(V) seen set, so any number can run
+//              side by side, and its own share of the packed
+//              arcs, so it walks the graph as it was when the
+//              range began even if the graph is edited.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class BreadthFirstRange {
+private:
+    typedef GraphNode<NodeType, ArcType> Node;
+
+    std::shared_ptr< CompactGraph<NodeType, ArcType> const > m_pArcs;
+    std::deque<int> m_queue;
+    BitSet m_seen;
+
+// -------------------------------------------------------
+// Description: Set by prune() to leave the front node's
+//              arcs unfollowed.
+// -------------------------------------------------------
+    bool m_pruned;
+
+public:
+    typedef TraversalIterator<BreadthFirstRange, Node> iterator;
+
+    BreadthFirstRange( std::shared_ptr< CompactGraph<NodeType, ArcType> const > const & pArcs, int start );
+
+    bool empty() const {
+        return m_queue.empty();
+    }
+
+    Node* front() const {
+        return m_pArcs->node( m_queue.front() );
+    }
+
+    void prune() {
+        m_pruned = true;
+    }
+
+    void next();
+
+    iterator begin() {
+        return iterator( this );
+    }
+
+    iterator end() {
+        return iterator();
+    }
+};
+
+// ----------------------------------------------------------------
+//  Name:           BreadthFirstRange
+//  Description:    Constructor, puts the start node at the front.
+//  Arguments:      A share of the packed arcs and the start node's
+//                  packed id, -1 for an empty range.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+BreadthFirstRange<NodeType, ArcType>::BreadthFirstRange( std::shared_ptr< CompactGraph<NodeType, ArcType> const > const & pArcs,
+                                                         int start )
+    : m_pArcs( pArcs ), m_seen( pArcs->size() ), m_pruned( false ) {
+    if( start >= 0 ) {
+        m_queue.push_back( start );
+        m_seen.set( start );
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           next
+//  Description:    Queues the unseen nodes the front node links to,
+//                  unless it was pruned, then moves past it.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void BreadthFirstRange<NodeType, ArcType>::next() {
+    int current = m_queue.front();
+    m_queue.pop_front();
+    if( !m_pruned ) {
+        for( int arc = m_pArcs->firstArc( current ); arc != m_pArcs->endArc( current ); arc++ ) {
+            int target = m_pArcs->target( arc );
+            if( !m_seen.test( target ) ) {
+                m_seen.set( target );
+                m_queue.push_back( target );
+            }
+        }
+    }
+    m_pruned = false;
+}
+
+// -------------------------------------------------------
+// Name:        DepthFirstRange
+// Description: A depth-first traversal that hands out its
+//              nodes one at a time, on request, in the order
+//              depthFirst visits them. It keeps the path down
+//              to the front node, each step with the next arc
+//              to try, and an O(V) seen set; prune() skips the
+//              rest of the front node's arcs. Like
+//              BreadthFirstRange, each keeps its own state and
+//              share of the packed arcs.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class DepthFirstRange {
+private:
+    typedef GraphNode<NodeType, ArcType> Node;
+
+    std::shared_ptr< CompactGraph<NodeType, ArcType> const > m_pArcs;
+
+// -------------------------------------------------------
+// Description: Each node on the way down, front node last,
+//              and the next of its arcs to follow.
+// -------------------------------------------------------
+    std::vector< std::pair<int, int> > m_frames;
+    BitSet m_seen;
+
+public:
+    typedef TraversalIterator<DepthFirstRange, Node> iterator;
+
+    DepthFirstRange( std::shared_ptr< CompactGraph<NodeType, ArcType> const > const & pArcs, int start );
+
+    bool empty() const {
+        return m_frames.empty();
+    }
+
+    Node* front() const {
+        return m_pArcs->node( m_frames.back().first );
+    }
+
+    // how far below the start the front node is.
+    int depth() const {
+        return (int)m_frames.size() - 1;
+    }
+
+    void prune() {
+        m_frames.back().second = m_pArcs->endArc( m_frames.back().first );
+    }
+
+    void next();
+
+    iterator begin() {
+        return iterator( this );
+    }
+
+    iterator end() {
+        return iterator();
+    }
+};
+
+// ----------------------------------------------------------------
+//  Name:           DepthFirstRange
+//  Description:    Constructor, puts the start node at the front.
+//  Arguments:      A share of the packed arcs and the start node's
+//                  packed id, -1 for an empty range.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+DepthFirstRange<NodeType, ArcType>::DepthFirstRange( std::shared_ptr< CompactGraph<NodeType, ArcType> const > const & pArcs,
+                                                     int start )
+    : m_pArcs( pArcs ), m_seen( pArcs->size() ) {
+    if( start >= 0 ) {
+        m_frames.push_back( std::make_pair( start, pArcs->firstArc( start ) ) );
+        m_seen.set( start );
+    }
+}
+
+// ----------------------------------------------------------------
+//  Name:           next
+//  Description:    Goes down the next unseen arc from the deepest
+//                  node that has one, backing up past nodes that
+//                  have none left.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void DepthFirstRange<NodeType, ArcType>::next() {
+    while( !m_frames.empty() ) {
+        std::pair<int, int>& frame = m_frames.back();
+        int endArc = m_pArcs->endArc( frame.first );
+        while( frame.second != endArc && m_seen.test( m_pArcs->target( frame.second ) ) ) {
+            frame.second++;
+        }
+        if( frame.second != endArc ) {
+            int child = m_pArcs->target( frame.second++ );
+            m_seen.set( child );
+            m_frames.push_back( std::make_pair( child, m_pArcs->firstArc( child ) ) );
+            return;
+        }
+        m_frames.pop_back();
+    }
+}
+
+#endif
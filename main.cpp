@@ -3,9 +3,9 @@
 #include <fstream>
 
 #include "Graph.h"
+#include "PathWriter.h"
 
 #include <string>
-#include <sstream>
 
 using namespace std;
 using std::pair;
@@ -16,10 +16,6 @@ using std::pair;
 typedef GraphArc<string, int> Arc;
 typedef GraphNode<pair<string, int>, int> Node;
 typedef vector<Node*> Path;
-typedef vector<pair<string, int>> PairPath;
-typedef vector<PairPath> PathMap;
-
-void empty(Node * pNode) {}
 
 void visit( Node * pNode ) {
 	cout << "Visiting: " << pNode->data().first << endl;
@@ -88,58 +84,6 @@ void outputPathPlusShort(Path* p)
 
 }
 
-void addPathToMap(PathMap& map, Path& p)
-{
-	//create a path of pairs
-	vector<pair<string, int>> pairpath;
-
-	Path::iterator pathE = p.end();
-	Path::iterator pathB = p.begin();
-	pathE--;
-
-	int lastCost = 0;
-
-	//Loop through path and add each node to the pair path
-	for (; pathE != pathB; pathE--) {
-		pairpath.push_back(pair<string, int>((*pathE)->data().first,  (*pathE)->data().second - lastCost));
-
-		lastCost = (*pathE)->data().second;
-	}
-	//last node
-	pairpath.push_back(pair<string, int>((*pathE)->data().first, (*pathE)->data().second - lastCost));
-
-	map.push_back(pairpath);
-}
-
-void outputPairPath(PairPath *p)
-{
-	cout << "=====" << "PP" << endl;
-	
-	//each node and it's distance added to a stringstream, add up the total distance
-	int i = 0;
-	int m = p->size();
-
-	std::stringstream s;
-	int total = 0;
-
-	for (; i < m; i++)
-	{
-		total += p->at(i).second;
-		s << p->at(i).first << "(" << p->at(i).second << ")";
-
-		if (i < m - 1)
-			s << "->";
-	}
-
-
-	//Path begin to path end, total distance
-	cout << "[" << p->begin()->first << "-" << (--p->end())->first << "]" << " [" << total << "]" << endl;
-	//Actual path
-	cout << s.str() << endl;
-
-	cout << "=====" << endl << endl;
-}
-
 int main(int argc, char *argv[]) {
 	cout << "LAB 5 START\n" << "==========" << endl;
 
@@ -179,7 +123,6 @@ int main(int argc, char *argv[]) {
 	//cout << endl;
 	//Max the distance in all nodes
 
-	Path path;
 	//graph.UCS(graph.nodeArray()[0], graph.nodeArray()[5], visit, path);
 
 	//outputPathPlus(&path);
@@ -195,7 +138,12 @@ int main(int argc, char *argv[]) {
 	//=====//UCS Precomputation
 	//cout << endl;
 
-	PathMap map;
+	//One path reused for every search, each written out as it is
+	//found. The writer holds the paths back until it fills or is
+	//flushed, so the search traces still come first.
+	PathResult path;
+	PathWriter<pair<string, int>, int> writer(graph, cout);
+	writer.write("-----\n");
 
 	//Iterate through map and calculate paths
 	//outer, inner, maxNodes
@@ -207,21 +155,16 @@ int main(int argc, char *argv[]) {
 	{
 		for (n = o + 1; n <= m; n++)
 		{
-			path.clear();
-			graph.UCS(graph.nodeArray()[o], graph.nodeArray()[n], empty, path);
-			addPathToMap(map, path);
+			// no route against the arc directions, so skip the search.
+			if (!graph.mayReach(o, n)) {
+				continue;
+			}
+			// the arcs were added both ways, so this runs UCS.
+			graph.shortestPath(graph.nodeArray()[o], graph.nodeArray()[n], path);
+			writer.write(path);
 		}
 	}
-
-	//Output path
-	PathMap::iterator pmI = map.begin();
-	PathMap::iterator pmE = map.end();
-
-	cout << "-----" << endl;
-	for (; pmI != pmE; pmI++)
-	{
-		outputPairPath(&*pmI);
-	}
+	writer.flush();
 
 	system("PAUSE");
 }
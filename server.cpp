@@ -0,0 +1,139 @@
+#include "stdafx.h"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <csignal>
+#include <pthread.h>
+
+#include "Graph.h"
+#include "QueryServer.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef Graph<pair<string, int>, int> RouteGraph;
+
+// ----------------------------------------------------------------
+//  Name:           loadGraph
+//  Description:    Reads the nodes and dual arcs in the files main
+//                  reads, sizing the graph to the node file.
+//  Arguments:      The node file and the arc file.
+//  Return Value:   The new graph, or 0 if the node file can't be read.
+// ----------------------------------------------------------------
+RouteGraph* loadGraph(string const & nodeFile, string const & arcFile)
+{
+	ifstream myfile(nodeFile.c_str());
+	if (!myfile) {
+		return 0;
+	}
+	vector<string> names;
+	string name;
+	while (myfile >> name) {
+		names.push_back(name);
+	}
+	myfile.close();
+
+	RouteGraph* pGraph = new RouteGraph((int)names.size());
+	for (size_t i = 0; i < names.size(); i++) {
+		pGraph->addNode(pair<string, int>(names[i], 0), (int)i);
+	}
+
+	myfile.open(arcFile.c_str());
+	int from, to, weight;
+	while (myfile >> from >> to >> weight) {
+		pGraph->addDualArc(from, to, weight);
+	}
+	return pGraph;
+}
+
+// ----------------------------------------------------------------
+//  Name:           query
+//  Description:    Client mode: sends the routes given on the
+//                  command line as one batch and prints the replies
+//                  in order, as main prints paths.
+//  Arguments:      The socket path, and the start and target index
+//                  pairs as text.
+//  Return Value:   The exit code.
+// ----------------------------------------------------------------
+int query(string const & path, vector<string> const & args)
+{
+	vector< pair<int, int> > routes;
+	for (size_t i = 0; i + 1 < args.size(); i += 2) {
+		routes.push_back(make_pair(atoi(args[i].c_str()), atoi(args[i + 1].c_str())));
+	}
+	int fd = connectQueryServer(path);
+	if (fd < 0) {
+		cerr << "Can't connect to " << path << endl;
+		return 1;
+	}
+	vector<int> costs;
+	vector<string> texts;
+	bool ok = askQueryServer(fd, routes, costs, texts);
+	close(fd);
+	if (!ok) {
+		cerr << "Connection to " << path << " failed" << endl;
+		return 1;
+	}
+	for (size_t i = 0; i < routes.size(); i++) {
+		if (costs[i] < 0) {
+			cout << "No route from " << routes[i].first << " to " << routes[i].second << endl;
+		}
+		else {
+			cout << texts[i];
+		}
+	}
+	return 0;
+}
+
+// ----------------------------------------------------------------
+//  Name:           main
+//  Description:    graphd SOCKET [THREADS] loads dornodes.txt and
+//                  dorarcs.txt once and serves route queries on the
+//                  socket until interrupted or terminated.
+//                  graphd SOCKET query FROM TO [FROM TO ...] asks a
+//                  running server for those routes.
+// ----------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		cerr << "usage: " << argv[0] << " SOCKET [THREADS]" << endl;
+		cerr << "       " << argv[0] << " SOCKET query FROM TO [FROM TO ...]" << endl;
+		return 1;
+	}
+	string path = argv[1];
+	if (argc > 2 && string(argv[2]) == "query") {
+		return query(path, vector<string>(argv + 3, argv + argc));
+	}
+
+	// block the stop signals before any thread starts, so only
+	// sigwait below sees them.
+	sigset_t stopSignals;
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &stopSignals, 0);
+
+	RouteGraph* pGraph = loadGraph("dornodes.txt", "dorarcs.txt");
+	if (pGraph == 0) {
+		cerr << "Can't read dornodes.txt" << endl;
+		return 1;
+	}
+	pGraph->publish();
+
+	QueryServer<pair<string, int>, int> server(*pGraph, path, argc > 2 ? atoi(argv[2]) : 0);
+	if (!server.start()) {
+		cerr << "Can't listen on " << path << endl;
+		delete pGraph;
+		return 1;
+	}
+	cout << "Serving " << pGraph->count() << " nodes on " << path << endl;
+
+	int signal;
+	sigwait(&stopSignals, &signal);
+	server.stop();
+	cout << "Answered " << server.answered() << " queries in " << server.batches() << " batches" << endl;
+	delete pGraph;
+	return 0;
+}
@@ -0,0 +1,1940 @@
+#include "stdafx.h"
+#include <iostream>
+#include <cassert>
+#include <climits>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <queue>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+// count search work, so the counters can be checked.
+#define GRAPH_SEARCH_STATS
+#include "Graph.h"
+#include "DynamicShortestPaths.h"
+#include "PathCache.h"
+#include "QueryServer.h"
+#include "PathWriter.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef Graph<pair<string, int>, int> RouteGraph;
+typedef GraphNode<pair<string, int>, int> Node;
+typedef GraphArc<pair<string, int>, int> Arc;
+
+// ----------------------------------------------------------------
+//  Name:           randomGraph
+//  Description:    Builds a graph of random one-way arcs, leaving
+//                  about one index in ten without a node so the
+//                  searches meet gaps in the node array.
+//  Arguments:      The number of indices and of arcs to try, the
+//                  lightest and heaviest weight, and the seed.
+//  Return Value:   The new graph.
+// ----------------------------------------------------------------
+RouteGraph* randomGraph(int size, int arcs, int minWeight, int maxWeight, unsigned int seed)
+{
+	mt19937 random(seed);
+	RouteGraph* pGraph = new RouteGraph(size);
+	for (int i = 0; i < size; i++) {
+		if (random() % 10 != 0) {
+			pGraph->addNode(pair<string, int>("n" + to_string(i), 0), i);
+		}
+	}
+	Node** pNodes = pGraph->nodeArray();
+	for (int i = 0; i < arcs; i++) {
+		int from = random() % size;
+		int to = random() % size;
+		int weight = minWeight + (int)(random() % (unsigned int)(maxWeight - minWeight + 1));
+		if (from != to && pNodes[from] != 0 && pNodes[to] != 0 && pGraph->getArc(from, to) == 0) {
+			pGraph->addArc(from, to, weight);
+		}
+	}
+	return pGraph;
+}
+
+// ----------------------------------------------------------------
+//  Name:           referenceDepthFirst
+//  Description:    Plain recursive depth-first search over the nodes'
+//                  own arc lists, with one clock for discovery and
+//                  finish times as depthFirst keeps them.
+//  Arguments:      The graph, the node index to go into, the pre-order
+//                  and post-order lists to add to, the discovery and
+//                  finish times, and the clock.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void referenceDepthFirst(RouteGraph& graph, int index, vector<int>& pre, vector<int>& post,
+                         vector<int>& discovery, vector<int>& finish, int& time)
+{
+	pre.push_back(index);
+	discovery[index] = time++;
+	list<Arc> const & arcs = graph.nodeArray()[index]->arcList();
+	for (typename list<Arc>::const_iterator iter = arcs.begin(); iter != arcs.end(); iter++) {
+		int to = graph.indexOf(iter->node());
+		if (discovery[to] == -1) {
+			referenceDepthFirst(graph, to, pre, post, discovery, finish, time);
+		}
+	}
+	post.push_back(index);
+	finish[index] = time++;
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkDepthFirst
+//  Description:    depthFirst's pre-order, post-order and times against
+//                  the recursive reference, then a chain far longer
+//                  than a recursive search's call stack would take.
+// ----------------------------------------------------------------
+void checkDepthFirst()
+{
+	for (unsigned int seed = 0; seed < 10; seed++) {
+		int const size = 300;
+		RouteGraph* pGraph = randomGraph(size, size * 2, 1, 9, seed);
+		Node** pNodes = pGraph->nodeArray();
+		int start = 0;
+		while (pNodes[start] == 0) {
+			start++;
+		}
+		vector<int> pre, post, discovery(size, -1), finish(size, -1);
+		int time = 0;
+		referenceDepthFirst(*pGraph, start, pre, post, discovery, finish, time);
+
+		vector<int> foundPre, foundPost, foundDiscovery, foundFinish;
+		pGraph->depthFirst(pNodes[start],
+		                   [&](Node* pNode) { foundPre.push_back(pGraph->indexOf(pNode)); },
+		                   [&](Node* pNode) { foundPost.push_back(pGraph->indexOf(pNode)); },
+		                   &foundDiscovery, &foundFinish);
+		assert(foundPre == pre && foundPost == post);
+		assert(foundDiscovery == discovery && foundFinish == finish);
+		delete pGraph;
+	}
+
+	int const length = 1000000;
+	RouteGraph chain(length);
+	for (int i = 0; i < length; i++) {
+		chain.addNode(pair<string, int>("c", 0), i);
+	}
+	for (int i = 0; i + 1 < length; i++) {
+		chain.addArc(i, i + 1, 1);
+	}
+	int visited = 0;
+	int finished = 0;
+	chain.depthFirst(chain.nodeArray()[0], [&](Node*) { visited++; }, [&](Node*) { finished++; });
+	assert(visited == length && finished == length);
+}
+
+// ----------------------------------------------------------------
+//  Name:           referenceCosts
+//  Description:    Plain Dijkstra over the nodes' own arc lists, to
+//                  check the other searches against.
+//  Arguments:      The graph, the start index, and the costs to fill
+//                  in by index, INT_MAX if unreachable.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void referenceCosts(RouteGraph& graph, int start, vector<int>& cost)
+{
+	Node** pNodes = graph.nodeArray();
+	cost.assign(graph.maxNodes(), INT_MAX);
+	priority_queue< pair<int, int>, vector< pair<int, int> >, greater< pair<int, int> > > pq;
+	cost[start] = 0;
+	pq.push(make_pair(0, start));
+	while (!pq.empty()) {
+		pair<int, int> top = pq.top();
+		pq.pop();
+		if (top.first != cost[top.second]) {
+			continue;
+		}
+		list<Arc> const & arcs = pNodes[top.second]->arcList();
+		for (typename list<Arc>::const_iterator iter = arcs.begin(); iter != arcs.end(); iter++) {
+			int to = graph.indexOf(iter->node());
+			if (top.first + iter->weight() < cost[to]) {
+				cost[to] = top.first + iter->weight();
+				pq.push(make_pair(cost[to], to));
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           referenceLevels
+//  Description:    Plain breadth-first search over the nodes' own arc
+//                  lists.
+//  Arguments:      The graph, the start index, and the level of each
+//                  index to fill in, -1 if unreached.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void referenceLevels(RouteGraph& graph, int start, vector<int>& level)
+{
+	Node** pNodes = graph.nodeArray();
+	level.assign(graph.maxNodes(), -1);
+	vector<int> queue(1, start);
+	level[start] = 0;
+	for (size_t front = 0; front < queue.size(); front++) {
+		list<Arc> const & arcs = pNodes[queue[front]]->arcList();
+		for (typename list<Arc>::const_iterator iter = arcs.begin(); iter != arcs.end(); iter++) {
+			int to = graph.indexOf(iter->node());
+			if (level[to] == -1) {
+				level[to] = level[queue[front]] + 1;
+				queue.push_back(to);
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkLevels
+//  Description:    Checks breadth-first levels against the reference,
+//                  and that each reached node's parent is one level up
+//                  with an arc to it.
+//  Arguments:      The graph, the parents and levels found, and the
+//                  reference levels.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void checkLevels(RouteGraph& graph, vector<int> const & parent, vector<int> const & found, vector<int> const & level)
+{
+	assert(found == level);
+	for (int i = 0; i < graph.maxNodes(); i++) {
+		if (found[i] > 0) {
+			assert(found[parent[i]] == found[i] - 1 && graph.getArc(parent[i], i) != 0);
+		}
+		else {
+			assert(parent[i] == -1);
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkHybridBreadthFirst
+//  Description:    breadthFirstHybrid against the reference levels, on
+//                  graphs sparse enough to stay top-down and dense
+//                  enough to go bottom-up, before and after edits.
+// ----------------------------------------------------------------
+void checkHybridBreadthFirst()
+{
+	for (unsigned int seed = 0; seed < 8; seed++) {
+		int const size = 1000 + (int)seed;
+		RouteGraph* pGraph = randomGraph(size, size * (seed % 2 == 0 ? 2 : 16), 1, 1, seed);
+		Node** pNodes = pGraph->nodeArray();
+		mt19937 random(seed);
+		for (int round = 0; round < 2; round++) {
+			int start = random() % size;
+			while (pNodes[start] == 0) {
+				start = (start + 1) % size;
+			}
+			vector<int> level, parent, found;
+			referenceLevels(*pGraph, start, level);
+			pGraph->breadthFirstHybrid(pNodes[start], parent, found);
+			checkLevels(*pGraph, parent, found, level);
+
+			for (int i = 0; i < 100; i++) {
+				int from = random() % size;
+				int to = random() % size;
+				if (from != to && pNodes[from] != 0 && pNodes[to] != 0) {
+					pGraph->removeArc(from, to);
+				}
+			}
+		}
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkParallelBreadthFirst
+//  Description:    breadthFirstParallel against the reference levels
+//                  on one to eight threads, including a long chain
+//                  that gives each level a single node.
+// ----------------------------------------------------------------
+void checkParallelBreadthFirst()
+{
+	for (unsigned int seed = 0; seed < 6; seed++) {
+		int const size = 2000;
+		RouteGraph* pGraph = randomGraph(size, size * 6, 1, 1, seed);
+		Node** pNodes = pGraph->nodeArray();
+		int start = (int)seed;
+		while (pNodes[start] == 0) {
+			start++;
+		}
+		vector<int> level;
+		referenceLevels(*pGraph, start, level);
+		for (int threads = 1; threads <= 8; threads *= 2) {
+			vector<int> parent, found;
+			pGraph->breadthFirstParallel(pNodes[start], parent, found, threads);
+			checkLevels(*pGraph, parent, found, level);
+		}
+		delete pGraph;
+	}
+
+	int const length = 5000;
+	RouteGraph chain(length);
+	for (int i = 0; i < length; i++) {
+		chain.addNode(pair<string, int>("c", 0), i);
+	}
+	for (int i = 0; i + 1 < length; i++) {
+		chain.addArc(i, i + 1, 1);
+	}
+	vector<int> level, parent, found;
+	referenceLevels(chain, 0, level);
+	chain.breadthFirstParallel(chain.nodeArray()[0], parent, found, 4);
+	checkLevels(chain, parent, found, level);
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkMultiSource
+//  Description:    breadthFirstMultiSource against one reference search
+//                  per source, with more than a word's worth of sources
+//                  and a source given twice.
+// ----------------------------------------------------------------
+void checkMultiSource()
+{
+	for (unsigned int seed = 0; seed < 4; seed++) {
+		int const size = 600;
+		RouteGraph* pGraph = randomGraph(size, size * 3, 1, 1, seed);
+		Node** pNodes = pGraph->nodeArray();
+		vector<Node*> sources;
+		for (int i = 0; i < size && sources.size() < 130; i += 3) {
+			if (pNodes[i] != 0) {
+				sources.push_back(pNodes[i]);
+			}
+		}
+		sources.push_back(sources.front());
+		vector< vector<int> > hops;
+		pGraph->breadthFirstMultiSource(sources, hops);
+		assert(hops.size() == sources.size());
+		for (size_t s = 0; s < sources.size(); s++) {
+			vector<int> level;
+			referenceLevels(*pGraph, pGraph->indexOf(sources[s]), level);
+			assert(hops[s] == level);
+		}
+		delete pGraph;
+	}
+}
+
+// visits counted by countVisit.
+int g_visits = 0;
+
+// ----------------------------------------------------------------
+//  Name:           countVisit
+//  Description:    A plain function visitor, the way visitors were
+//                  passed before they were templates.
+//  Arguments:      The node visited.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void countVisit(Node*)
+{
+	g_visits++;
+}
+
+// ----------------------------------------------------------------
+//  Name:           PruneOdd
+//  Description:    A visitor object that records the nodes it sees and
+//                  prunes those at odd indices.
+// ----------------------------------------------------------------
+struct PruneOdd {
+	RouteGraph* pGraph;
+	vector<int>* pSeen;
+
+	VisitResult operator()(Node* pNode) const {
+		int index = pGraph->indexOf(pNode);
+		pSeen->push_back(index);
+		return index % 2 == 1 ? VISIT_PRUNE : VISIT_CONTINUE;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           checkVisitors
+//  Description:    Visitors as plain functions, lambdas and objects;
+//                  VISIT_PRUNE against a reference breadth-first search
+//                  that skips the same nodes' arcs, and VISIT_STOP
+//                  ending both traversals after a set number of nodes.
+// ----------------------------------------------------------------
+void checkVisitors()
+{
+	for (unsigned int seed = 0; seed < 6; seed++) {
+		int const size = 300;
+		RouteGraph* pGraph = randomGraph(size, size * 3, 1, 1, seed);
+		Node** pNodes = pGraph->nodeArray();
+		int start = 0;
+		while (pNodes[start] == 0) {
+			start++;
+		}
+
+		vector<int> expected(1, start);
+		vector<char> seen(size, 0);
+		seen[start] = 1;
+		for (size_t front = 0; front < expected.size(); front++) {
+			if (expected[front] % 2 == 1) {
+				continue;
+			}
+			list<Arc> const & arcs = pNodes[expected[front]]->arcList();
+			for (typename list<Arc>::const_iterator iter = arcs.begin(); iter != arcs.end(); iter++) {
+				int to = pGraph->indexOf(iter->node());
+				if (!seen[to]) {
+					seen[to] = 1;
+					expected.push_back(to);
+				}
+			}
+		}
+		vector<int> pruned;
+		PruneOdd prune = { pGraph, &pruned };
+		pGraph->breadthFirst(pNodes[start], prune);
+		assert(pruned == expected);
+
+		vector<int> all;
+		pGraph->breadthFirst(pNodes[start], [&](Node* pNode) { all.push_back(pGraph->indexOf(pNode)); });
+		g_visits = 0;
+		pGraph->breadthFirst(pNodes[start], countVisit);
+		assert(g_visits == (int)all.size());
+
+		int const limit = 5;
+		vector<int> stopped;
+		pGraph->breadthFirst(pNodes[start], [&](Node* pNode) {
+			stopped.push_back(pGraph->indexOf(pNode));
+			return (int)stopped.size() == limit ? VISIT_STOP : VISIT_CONTINUE;
+		});
+		assert((int)stopped.size() == min(limit, (int)all.size()));
+		assert(equal(stopped.begin(), stopped.end(), all.begin()));
+
+		vector<int> deep;
+		pGraph->depthFirst(pNodes[start], [&](Node* pNode) { deep.push_back(pGraph->indexOf(pNode)); });
+		vector<int> deepStopped;
+		pGraph->depthFirst(pNodes[start], [&](Node* pNode) {
+			deepStopped.push_back(pGraph->indexOf(pNode));
+			return (int)deepStopped.size() == limit ? VISIT_STOP : VISIT_CONTINUE;
+		});
+		assert((int)deepStopped.size() == min(limit, (int)deep.size()));
+		assert(equal(deepStopped.begin(), deepStopped.end(), deep.begin()));
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkDeltaStepping
+//  Description:    deltaStepping's costs against the reference on one
+//                  to eight threads and several bucket widths, with
+//                  each previous node one arc back on a cheapest path.
+// ----------------------------------------------------------------
+void checkDeltaStepping()
+{
+	int const weights[][2] = { { 1, 1 }, { 0, 3 }, { 1, 100 } };
+	for (unsigned int seed = 0; seed < 6; seed++) {
+		int const size = 800;
+		RouteGraph* pGraph = randomGraph(size, size * 4, weights[seed % 3][0], weights[seed % 3][1], seed);
+		Node** pNodes = pGraph->nodeArray();
+		int start = (int)seed;
+		while (pNodes[start] == 0) {
+			start++;
+		}
+		vector<int> cost;
+		referenceCosts(*pGraph, start, cost);
+		int const deltas[] = { 0, 1, 7, 1000 };
+		for (int threads = 1; threads <= 8; threads *= 2) {
+			for (int d = 0; d < 4; d++) {
+				vector<int> dist, prev;
+				pGraph->deltaStepping(pNodes[start], dist, prev, deltas[d], threads);
+				assert(dist == cost);
+				for (int i = 0; i < size; i++) {
+					if (i != start && dist[i] != INT_MAX) {
+						assert(dist[prev[i]] + pGraph->getArc(prev[i], i)->weight() == dist[i]);
+					}
+				}
+			}
+		}
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkRepairs
+//  Description:    Costs kept by DynamicShortestPaths against fresh
+//                  reference searches after each random arc added or
+//                  removed, with every changed cost listed once.
+//  Arguments:      The graph to edit, and the seed for the edits.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void checkRepairs(RouteGraph* pGraph, unsigned int seed)
+{
+	int const size = pGraph->maxNodes();
+	Node** pNodes = pGraph->nodeArray();
+	vector<int> sources;
+	for (int i = 0; sources.size() < 5; i += 37) {
+		if (pNodes[i % size] != 0) {
+			sources.push_back(i % size);
+		}
+	}
+	DynamicShortestPaths<pair<string, int>, int> paths(*pGraph, sources);
+	vector< vector<int> > before(sources.size());
+	for (size_t s = 0; s < sources.size(); s++) {
+		referenceCosts(*pGraph, sources[s], before[s]);
+		for (int i = 0; i < size; i++) {
+			assert(paths.cost((int)s, i) == before[s][i]);
+		}
+	}
+
+	mt19937 random(seed);
+	for (int edit = 0; edit < 300; edit++) {
+		int from = random() % size;
+		int to = random() % size;
+		if (from == to || pNodes[from] == 0 || pNodes[to] == 0) {
+			continue;
+		}
+		if (pGraph->getArc(from, to) != 0) {
+			pGraph->removeArc(from, to);
+		} else {
+			pGraph->addArc(from, to, 1 + (int)(random() % 20));
+		}
+		vector< pair<int, int> > changes = paths.changes();
+		sort(changes.begin(), changes.end());
+		assert(unique(changes.begin(), changes.end()) == changes.end());
+		for (size_t s = 0; s < sources.size(); s++) {
+			vector<int> cost;
+			referenceCosts(*pGraph, sources[s], cost);
+			for (int i = 0; i < size; i++) {
+				assert(paths.cost((int)s, i) == cost[i]);
+				bool listed = binary_search(changes.begin(), changes.end(), make_pair((int)s, i));
+				assert(listed == (cost[i] != before[s][i]));
+				int prev = paths.previous((int)s, i);
+				if (i != sources[s] && cost[i] != INT_MAX) {
+					assert(cost[prev] + pGraph->getArc(prev, i)->weight() == cost[i]);
+				}
+			}
+			before[s] = cost;
+		}
+		paths.clearChanges();
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkDynamicShortestPaths
+//  Description:    Runs checkRepairs on a few random graphs, each
+//                  deleted once its listener is gone.
+// ----------------------------------------------------------------
+void checkDynamicShortestPaths()
+{
+	for (unsigned int seed = 0; seed < 4; seed++) {
+		RouteGraph* pGraph = randomGraph(200, 400, 1, 20, seed);
+		checkRepairs(pGraph, seed);
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkPathCache
+//  Description:    PathCache's paths and costs against the reference,
+//                  its hits and misses against a plain least-recently-
+//                  used list, and dropping everything after an edit.
+// ----------------------------------------------------------------
+void checkPathCache()
+{
+	int const size = 120;
+	int const capacity = 8;
+	RouteGraph* pGraph = randomGraph(size, size * 3, 1, 30, 7);
+	Node** pNodes = pGraph->nodeArray();
+	PathCache<pair<string, int>, int> cache(*pGraph, capacity);
+	vector<int> present;
+	for (int i = 0; i < size; i++) {
+		if (pNodes[i] != 0) {
+			present.push_back(i);
+		}
+	}
+
+	mt19937 random(7);
+	list< pair<int, int> > recent;
+	long long hits = 0;
+	long long misses = 0;
+	long long invalidations = 0;
+	for (int round = 0; round < 2000; round++) {
+		if (round % 250 == 249) {
+			int from = present[random() % present.size()];
+			int to = present[random() % present.size()];
+			if (from != to && pGraph->getArc(from, to) == 0) {
+				pGraph->addArc(from, to, 1 + (int)(random() % 30));
+				if (!recent.empty()) {
+					invalidations++;
+				}
+				recent.clear();
+			}
+		}
+		// a small pool of pairs so entries are both reused and evicted.
+		int start = present[random() % 4];
+		int target = present[random() % 12 + 4];
+		pair<int, int> key(start, target);
+		list< pair<int, int> >::iterator found = find(recent.begin(), recent.end(), key);
+		if (found != recent.end()) {
+			hits++;
+			recent.erase(found);
+		} else {
+			misses++;
+			if ((int)recent.size() == capacity) {
+				recent.pop_back();
+			}
+		}
+		recent.push_front(key);
+
+		vector<Node*> path;
+		vector<int> costs;
+		int cost = cache.query(start, target, path, &costs);
+		vector<int> reference;
+		referenceCosts(*pGraph, start, reference);
+		assert(cost == reference[target]);
+		assert(costs.size() == path.size());
+		if (cost != INT_MAX) {
+			assert(path.front() == pNodes[target] && path.back() == pNodes[start]);
+			for (size_t i = 0; i < path.size(); i++) {
+				assert(costs[i] == reference[pGraph->indexOf(path[i])]);
+				if (i + 1 < path.size()) {
+					assert(pGraph->getArc(pGraph->indexOf(path[i + 1]), pGraph->indexOf(path[i])) != 0);
+				}
+			}
+		}
+		assert(cache.hits() == hits && cache.misses() == misses);
+		assert(cache.invalidations() == invalidations);
+		assert(cache.size() == (int)recent.size());
+	}
+	assert(hits > 0 && misses > 0 && invalidations > 0);
+	delete pGraph;
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkRoute
+//  Description:    Checks a path a search gave: target first, start
+//                  last, each step an arc, and weights adding up to the
+//                  cost. An unreachable target must have no path.
+//  Arguments:      The graph, the path, the start and target indices,
+//                  and the expected cost.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void checkRoute(RouteGraph& graph, vector<Node*> const & path, int start, int target, int cost)
+{
+	if (cost == INT_MAX) {
+		assert(path.empty());
+		return;
+	}
+	assert(!path.empty());
+	assert(graph.indexOf(path.front()) == target && graph.indexOf(path.back()) == start);
+	int total = 0;
+	for (size_t i = 0; i + 1 < path.size(); i++) {
+		Arc* pArc = graph.getArc(graph.indexOf(path[i + 1]), graph.indexOf(path[i]));
+		assert(pArc != 0);
+		total += pArc->weight();
+	}
+	assert(total == cost);
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkUCSMany
+//  Description:    UCSMany against the reference, with repeated
+//                  targets, the start itself, unreachable targets and
+//                  a node that is not in the graph.
+// ----------------------------------------------------------------
+void checkUCSMany()
+{
+	for (unsigned int seed = 0; seed < 6; seed++) {
+		int const size = 300;
+		RouteGraph* pGraph = randomGraph(size, size * 2, 1, 50, seed);
+		Node** pNodes = pGraph->nodeArray();
+		mt19937 random(seed);
+		Node stranger;
+		for (int round = 0; round < 10; round++) {
+			int start = random() % size;
+			if (pNodes[start] == 0) {
+				continue;
+			}
+			vector<Node*> targets;
+			targets.push_back(pNodes[start]);
+			targets.push_back(&stranger);
+			for (int t = 0; t < 20; t++) {
+				int target = random() % size;
+				if (pNodes[target] != 0) {
+					targets.push_back(pNodes[target]);
+					targets.push_back(pNodes[target]);
+				}
+			}
+			vector< vector<Node*> > paths;
+			vector<int> costs;
+			pGraph->UCSMany(pNodes[start], targets, paths, costs);
+			vector<int> reference;
+			referenceCosts(*pGraph, start, reference);
+			assert(paths.size() == targets.size() && costs.size() == targets.size());
+			assert(costs[1] == INT_MAX && paths[1].empty());
+			for (size_t t = 0; t < targets.size(); t++) {
+				if (targets[t] != &stranger) {
+					int target = pGraph->indexOf(targets[t]);
+					assert(costs[t] == reference[target]);
+					checkRoute(*pGraph, paths[t], start, target, costs[t]);
+				}
+			}
+		}
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkUCSRange
+//  Description:    UCSRange against the reference: exactly the nodes
+//                  within the budget, each with its cost, cheapest
+//                  first, for budgets from nothing to everything.
+// ----------------------------------------------------------------
+void checkUCSRange()
+{
+	for (unsigned int seed = 0; seed < 6; seed++) {
+		int const size = 300;
+		RouteGraph* pGraph = randomGraph(size, size * 3, 0, 40, seed);
+		Node** pNodes = pGraph->nodeArray();
+		int start = (int)seed;
+		while (pNodes[start] == 0) {
+			start++;
+		}
+		vector<int> reference;
+		referenceCosts(*pGraph, start, reference);
+		int const budgets[] = { -1, 0, 15, 60, 150, INT_MAX };
+		for (int b = 0; b < 6; b++) {
+			vector< pair<Node*, int> > reached;
+			pGraph->UCSRange(pNodes[start], budgets[b], reached);
+			vector<char> seen(size, 0);
+			for (size_t i = 0; i < reached.size(); i++) {
+				int index = pGraph->indexOf(reached[i].first);
+				assert(!seen[index]);
+				seen[index] = 1;
+				assert(reached[i].second == reference[index]);
+				assert(i == 0 || reached[i - 1].second <= reached[i].second);
+			}
+			for (int i = 0; i < size; i++) {
+				assert(seen[i] == (reference[i] != INT_MAX && reference[i] <= budgets[b]));
+			}
+		}
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkPacking
+//  Description:    Checks the packed arcs against the graph: ids and
+//                  indices map one to one, and each node's packed arcs
+//                  are its own arcs under the new numbering.
+//  Arguments:      The graph.
+//  Return Value:   true if any node's packed id differs from its index.
+// ----------------------------------------------------------------
+bool checkPacking(RouteGraph& graph)
+{
+	CompactGraph<pair<string, int>, int> const & packed = graph.compact();
+	Node** pNodes = graph.nodeArray();
+	bool moved = false;
+	for (int i = 0; i < graph.maxNodes(); i++) {
+		int id = packed.internal(i);
+		assert(packed.external(id) == i);
+		moved = moved || id != i;
+		assert(packed.node(id) == pNodes[i]);
+		if (pNodes[i] == 0) {
+			continue;
+		}
+		vector< pair<int, int> > arcs, expected;
+		packed.forEachArc(id, [&](int to, int weight) { arcs.push_back(make_pair(packed.external(to), weight)); });
+		list<Arc> const & arcList = pNodes[i]->arcList();
+		for (typename list<Arc>::const_iterator iter = arcList.begin(); iter != arcList.end(); iter++) {
+			expected.push_back(make_pair(graph.indexOf(iter->node()), iter->weight()));
+		}
+		sort(arcs.begin(), arcs.end());
+		sort(expected.begin(), expected.end());
+		assert(arcs == expected);
+	}
+	return moved;
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkSearchResults
+//  Description:    Runs searches that work on packed ids from a few
+//                  starts and checks they still answer in indices.
+//  Arguments:      The graph.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void checkSearchResults(RouteGraph& graph)
+{
+	Node** pNodes = graph.nodeArray();
+	vector<Node*> targets;
+	for (int i = 0; i < graph.maxNodes(); i++) {
+		if (pNodes[i] != 0) {
+			targets.push_back(pNodes[i]);
+		}
+	}
+	for (int start = 0; start < graph.maxNodes(); start += 41) {
+		if (pNodes[start] == 0) {
+			continue;
+		}
+		vector<int> cost, level;
+		referenceCosts(graph, start, cost);
+		referenceLevels(graph, start, level);
+
+		vector< vector<Node*> > paths;
+		vector<int> costs;
+		graph.UCSMany(pNodes[start], targets, paths, costs);
+		for (size_t t = 0; t < targets.size(); t++) {
+			int target = graph.indexOf(targets[t]);
+			assert(costs[t] == cost[target]);
+			checkRoute(graph, paths[t], start, target, costs[t]);
+		}
+
+		vector<int> dist, prev, parent, found;
+		graph.deltaStepping(pNodes[start], dist, prev, 0, 2);
+		assert(dist == cost);
+		graph.breadthFirstHybrid(pNodes[start], parent, found);
+		checkLevels(graph, parent, found, level);
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkNodeOrders
+//  Description:    Every numbering against the graph and the searches
+//                  against the reference, before and after edits that
+//                  patch the reordered arcs.
+// ----------------------------------------------------------------
+void checkNodeOrders()
+{
+	NodeOrder const orders[] = { ORDER_INDEX, ORDER_BFS, ORDER_RCM, ORDER_HILBERT };
+	for (int o = 0; o < 4; o++) {
+		int const size = 400;
+		RouteGraph* pGraph = randomGraph(size, size * 3, 1, 25, o);
+		Node** pNodes = pGraph->nodeArray();
+		mt19937 random(o);
+		vector< pair<double, double> > positions;
+		for (int i = 0; i < size; i++) {
+			positions.push_back(make_pair(random() % 1000 / 10.0, random() % 1000 / 10.0));
+		}
+		pGraph->setOrder(orders[o], positions);
+		assert(checkPacking(*pGraph) == (orders[o] != ORDER_INDEX));
+		checkSearchResults(*pGraph);
+
+		for (int edit = 0; edit < 60; edit++) {
+			int from = random() % size;
+			int to = random() % size;
+			if (edit % 20 == 19) {
+				pGraph->removeNode(from);
+			} else if (pNodes[from] != 0 && pNodes[to] != 0 && from != to) {
+				if (pGraph->getArc(from, to) != 0) {
+					pGraph->removeArc(from, to);
+				} else {
+					pGraph->addArc(from, to, 1 + (int)(random() % 25));
+				}
+			}
+		}
+		checkPacking(*pGraph);
+		checkSearchResults(*pGraph);
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           compressedArcs
+//  Description:    Decodes every arc of a compressed graph.
+//  Arguments:      The compressed graph.
+//  Return Value:   (from, to, weight) by id, in stored order.
+// ----------------------------------------------------------------
+vector< pair<int, pair<int, int> > > compressedArcs(CompressedGraph<pair<string, int>, int> const & arcs)
+{
+	vector< pair<int, pair<int, int> > > found;
+	for (int id = 0; id < arcs.size(); id++) {
+		arcs.forEachArc(id, [&](int to, int weight) { found.push_back(make_pair(id, make_pair(to, weight))); });
+	}
+	return found;
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkCompressedGraph
+//  Description:    Round trips through CompressedGraph built from the
+//                  packed arcs, from arc records and from a file, then
+//                  its searches against the reference, including from
+//                  nodes the compressed arcs don't cover.
+// ----------------------------------------------------------------
+void checkCompressedGraph()
+{
+	for (unsigned int seed = 0; seed < 4; seed++) {
+		int const size = 300;
+		RouteGraph* pGraph = randomGraph(size, size * 3, seed == 0 ? 10 : 1, seed == 0 ? 10 : 60, seed);
+		Node** pNodes = pGraph->nodeArray();
+		pGraph->setOrder(seed % 2 == 0 ? ORDER_INDEX : ORDER_RCM);
+		CompactGraph<pair<string, int>, int> const & packed = pGraph->compact();
+
+		// from the packed arcs, keeping their ids, each node's arcs
+		// in target order.
+		CompressedGraph<pair<string, int>, int> fromPacked;
+		fromPacked.build(packed);
+		vector< pair<int, pair<int, int> > > expected;
+		for (int id = 0; id < packed.size(); id++) {
+			packed.forEachArc(id, [&](int to, int weight) { expected.push_back(make_pair(id, make_pair(to, weight))); });
+		}
+		sort(expected.begin(), expected.end());
+		assert(compressedArcs(fromPacked) == expected);
+		assert(fromPacked.arcCount() == (int)expected.size());
+		assert(fromPacked.minWeight() == packed.minWeight() && fromPacked.maxWeight() == packed.maxWeight());
+		for (int i = 0; i < size; i++) {
+			assert(fromPacked.internal(i) == packed.internal(i) && fromPacked.external(packed.internal(i)) == i);
+			for (int j = 0; j < size; j += 7) {
+				if (pNodes[i] != 0 && pNodes[j] != 0) {
+					bool same = fromPacked.component(fromPacked.internal(i)) == fromPacked.component(fromPacked.internal(j));
+					assert(same == pGraph->connected(i, j));
+				}
+			}
+		}
+
+		// from records and from a file, by node index, with a line
+		// the file load has to skip.
+		vector< ArcRecord<int> > records;
+		string const file = "/tmp/compressed_arcs_" + to_string(seed) + ".txt";
+		ofstream out(file.c_str());
+		for (int i = 0; i < size; i++) {
+			if (pNodes[i] != 0) {
+				list<Arc> const & arcList = pNodes[i]->arcList();
+				for (typename list<Arc>::const_iterator iter = arcList.begin(); iter != arcList.end(); iter++) {
+					ArcRecord<int> record = { i, pGraph->indexOf(iter->node()), iter->weight() };
+					records.push_back(record);
+					out << record.from << " " << record.to << " " << record.weight << endl;
+				}
+			}
+		}
+		out << 0 << " " << size << " " << 5 << endl;
+		out.close();
+		expected.clear();
+		for (size_t r = 0; r < records.size(); r++) {
+			expected.push_back(make_pair(records[r].from, make_pair(records[r].to, records[r].weight)));
+		}
+		sort(expected.begin(), expected.end());
+		CompressedGraph<pair<string, int>, int> fromRecords;
+		fromRecords.build(size, records.begin(), records.end());
+		assert(compressedArcs(fromRecords) == expected);
+		CompressedGraph<pair<string, int>, int> fromFile;
+		assert(fromFile.load(file, size));
+		assert(compressedArcs(fromFile) == expected);
+		CompressedGraph<pair<string, int>, int> dual;
+		assert(dual.load(file, size, true));
+		// both ways, the first arc read between two nodes kept.
+		map< pair<int, int>, int > both;
+		for (size_t r = 0; r < records.size(); r++) {
+			both.insert(make_pair(make_pair(records[r].from, records[r].to), records[r].weight));
+			both.insert(make_pair(make_pair(records[r].to, records[r].from), records[r].weight));
+		}
+		expected.clear();
+		for (map< pair<int, int>, int >::iterator iter = both.begin(); iter != both.end(); iter++) {
+			expected.push_back(make_pair(iter->first.first, make_pair(iter->first.second, iter->second)));
+		}
+		assert(compressedArcs(dual) == expected);
+		remove(file.c_str());
+
+		// the searches over each give what they give over the graph.
+		for (int start = 0; start < size; start += 29) {
+			if (pNodes[start] == 0) {
+				continue;
+			}
+			vector<int> cost, level;
+			referenceCosts(*pGraph, start, cost);
+			referenceLevels(*pGraph, start, level);
+			CompressedGraph<pair<string, int>, int> const * pArcs[] = { &fromPacked, &fromRecords, &fromFile };
+			for (int a = 0; a < 3; a++) {
+				vector<int> found(size, -1);
+				int visits = 0;
+				pGraph->breadthFirst(*pArcs[a], pNodes[start], [&](Node* pNode) { found[pGraph->indexOf(pNode)] = 1; visits++; });
+				for (int i = 0; i < size; i++) {
+					assert((found[i] == 1) == (level[i] != -1));
+				}
+				for (int target = 0; target < size; target += 13) {
+					if (pNodes[target] != 0) {
+						vector<Node*> path;
+						pGraph->UCS(*pArcs[a], pNodes[start], pNodes[target], NoVisit(), path);
+						checkRoute(*pGraph, path, start, target, cost[target]);
+					}
+				}
+			}
+		}
+
+		// arcs covering only the first half of the indices have
+		// nothing to say about the rest.
+		CompressedGraph<pair<string, int>, int> half;
+		vector< ArcRecord<int> > low;
+		for (size_t r = 0; r < records.size(); r++) {
+			if (records[r].from < size / 2 && records[r].to < size / 2) {
+				low.push_back(records[r]);
+			}
+		}
+		half.build(size / 2, low.begin(), low.end());
+		for (int i = size / 2; i < size; i++) {
+			if (pNodes[i] != 0) {
+				int visits = 0;
+				pGraph->breadthFirst(half, pNodes[i], [&](Node*) { visits++; });
+				vector<Node*> path;
+				pGraph->UCS(half, pNodes[i], pNodes[0], NoVisit(), path);
+				assert(visits == 0 && path.empty());
+			}
+		}
+		Node stranger;
+		int visits = 0;
+		pGraph->breadthFirst(fromPacked, &stranger, [&](Node*) { visits++; });
+		assert(visits == 0);
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           referenceComponents
+//  Description:    Labels weakly connected components by a plain
+//                  search over the arcs taken both ways.
+//  Arguments:      The graph, and the labels to fill in by index,
+//                  -1 for empty slots.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void referenceComponents(RouteGraph& graph, vector<int>& label)
+{
+	int const size = graph.maxNodes();
+	Node** pNodes = graph.nodeArray();
+	vector< vector<int> > both(size);
+	for (int i = 0; i < size; i++) {
+		if (pNodes[i] != 0) {
+			list<Arc> const & arcs = pNodes[i]->arcList();
+			for (typename list<Arc>::const_iterator iter = arcs.begin(); iter != arcs.end(); iter++) {
+				int to = graph.indexOf(iter->node());
+				both[i].push_back(to);
+				both[to].push_back(i);
+			}
+		}
+	}
+	label.assign(size, -1);
+	for (int i = 0; i < size; i++) {
+		if (pNodes[i] == 0 || label[i] != -1) {
+			continue;
+		}
+		vector<int> stack(1, i);
+		label[i] = i;
+		while (!stack.empty()) {
+			int u = stack.back();
+			stack.pop_back();
+			for (size_t k = 0; k < both[u].size(); k++) {
+				if (label[both[u][k]] == -1) {
+					label[both[u][k]] = i;
+					stack.push_back(both[u][k]);
+				}
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkEdits
+//  Description:    Edits naming missing or out of range nodes are
+//                  refused, and components stay right through random
+//                  node and arc edits, including a node put back in a
+//                  slot whose old node had one neighbour.
+// ----------------------------------------------------------------
+void checkEdits()
+{
+	RouteGraph graph(4);
+	graph.addNode(pair<string, int>("a", 0), 0);
+	graph.addNode(pair<string, int>("b", 0), 1);
+	assert(!graph.addNode(pair<string, int>("x", 0), -1) && !graph.addNode(pair<string, int>("x", 0), 4));
+	assert(!graph.addArc(0, 2, 1) && !graph.addArc(2, 0, 1) && !graph.addDualArc(0, 2, 1));
+	assert(!graph.addArc(-1, 0, 1) && !graph.addArc(0, 4, 1) && !graph.addDualArc(4, 0, 1) && !graph.addDualArc(0, -1, 1));
+	assert(graph.getArc(0, 4) == 0 && graph.getArc(-1, 0) == 0);
+	graph.removeArc(0, 4);
+	graph.removeArc(-1, 1);
+	graph.removeNode(-1);
+	graph.removeNode(4);
+	assert(graph.count() == 2);
+
+	// the slot is left joined to node 0 when its node goes.
+	assert(graph.addDualArc(0, 1, 3));
+	assert(graph.connected(0, 1));
+	graph.removeNode(1);
+	assert(graph.component(1) == -1);
+	graph.addNode(pair<string, int>("c", 0), 1);
+	assert(!graph.connected(0, 1));
+	vector<Node*> path;
+	graph.UCS(graph.nodeArray()[0], graph.nodeArray()[1], NoVisit(), path);
+	assert(path.empty());
+
+	int const size = 120;
+	RouteGraph* pGraph = randomGraph(size, size / 2, 1, 9, 3);
+	Node** pNodes = pGraph->nodeArray();
+	mt19937 random(3);
+	for (int edit = 0; edit < 3000; edit++) {
+		int from = (int)(random() % (size + 2)) - 1;
+		int to = (int)(random() % (size + 2)) - 1;
+		bool exist = from >= 0 && from < size && to >= 0 && to < size && pNodes[from] != 0 && pNodes[to] != 0;
+		switch (random() % 6) {
+		case 0:
+			pGraph->removeNode(from);
+			break;
+		case 1: {
+			bool empty = from >= 0 && from < size && pNodes[from] == 0;
+			assert(pGraph->addNode(pair<string, int>("n", 0), from) == empty);
+			break;
+		}
+		case 2:
+			if (pGraph->addArc(from, to, 1)) {
+				assert(exist);
+			}
+			break;
+		case 3:
+			if (pGraph->addDualArc(from, to, 1)) {
+				assert(exist);
+			}
+			break;
+		default:
+			pGraph->removeArc(from, to);
+			break;
+		}
+		if (edit % 50 == 0) {
+			vector<int> label;
+			referenceComponents(*pGraph, label);
+			for (int i = 0; i < size; i++) {
+				for (int j = 0; j < size; j++) {
+					assert(pGraph->connected(i, j) == (label[i] != -1 && label[i] == label[j]));
+				}
+			}
+		}
+	}
+	delete pGraph;
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkStrongComponents
+//  Description:    strongComponents against mutual reachability from
+//                  the reference search, the numbering against the
+//                  arcs, the condensation, mayReach, and a cycle far
+//                  longer than a recursive search's call stack.
+// ----------------------------------------------------------------
+void checkStrongComponents()
+{
+	for (unsigned int seed = 0; seed < 8; seed++) {
+		int const size = 150;
+		RouteGraph* pGraph = randomGraph(size, size + (int)seed * 20, 1, 5, seed);
+		Node** pNodes = pGraph->nodeArray();
+		vector< vector<int> > level(size);
+		for (int i = 0; i < size; i++) {
+			if (pNodes[i] != 0) {
+				referenceLevels(*pGraph, i, level[i]);
+			}
+		}
+		vector<int> component;
+		vector< vector<int> > dag;
+		int count = pGraph->strongComponents(component, &dag);
+		assert((int)dag.size() == count);
+		vector<char> used(count, 0);
+		vector< vector<int> > expected(count);
+		for (int i = 0; i < size; i++) {
+			if (pNodes[i] == 0) {
+				assert(component[i] == -1);
+				continue;
+			}
+			assert(component[i] >= 0 && component[i] < count);
+			used[component[i]] = 1;
+			for (int j = 0; j < size; j++) {
+				if (pNodes[j] != 0) {
+					bool mutual = level[i][j] != -1 && level[j][i] != -1;
+					assert((component[i] == component[j]) == mutual);
+					if (level[i][j] != -1) {
+						assert(pGraph->mayReach(i, j));
+					}
+				}
+			}
+			list<Arc> const & arcs = pNodes[i]->arcList();
+			for (typename list<Arc>::const_iterator iter = arcs.begin(); iter != arcs.end(); iter++) {
+				int to = component[pGraph->indexOf(iter->node())];
+				assert(component[i] <= to);
+				if (component[i] != to) {
+					expected[component[i]].push_back(to);
+				}
+			}
+		}
+		assert(find(used.begin(), used.end(), 0) == used.end());
+		for (int c = 0; c < count; c++) {
+			sort(expected[c].begin(), expected[c].end());
+			expected[c].erase(unique(expected[c].begin(), expected[c].end()), expected[c].end());
+		}
+		assert(dag == expected);
+		delete pGraph;
+	}
+
+	int const length = 300000;
+	RouteGraph cycle(length);
+	for (int i = 0; i < length; i++) {
+		cycle.addNode(pair<string, int>("c", 0), i);
+	}
+	for (int i = 0; i < length; i++) {
+		cycle.addArc(i, (i + 1) % length, 1);
+	}
+	vector<int> component;
+	assert(cycle.strongComponents(component) == 1);
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkSpanningForest
+//  Description:    Parallel Boruvka against Kruskal, on graphs of dual
+//                  arcs with a few one-way arcs and many equal weights.
+// ----------------------------------------------------------------
+void checkSpanningForest()
+{
+	for (unsigned int seed = 0; seed < 10; seed++) {
+		mt19937 random(seed);
+		int const size = 500;
+		RouteGraph graph(size);
+		for (int i = 0; i < size; i++) {
+			graph.addNode(pair<string, int>("n" + to_string(i), 0), i);
+		}
+		for (int i = 0; i < size * 2; i++) {
+			int from = random() % size;
+			int to = random() % size;
+			if (from != to && graph.getArc(from, to) == 0 && graph.getArc(to, from) == 0) {
+				if (random() % 8 == 0) {
+					graph.addArc(from, to, random() % 5);
+				}
+				else {
+					graph.addDualArc(from, to, random() % 5);
+				}
+			}
+		}
+		vector< pair<int, int> > expected;
+		int weight = graph.minimumSpanningForestKruskal(expected);
+		sort(expected.begin(), expected.end());
+		for (int threads = 1; threads <= 4; threads++) {
+			vector< pair<int, int> > chosen;
+			assert(graph.minimumSpanningForest(chosen, threads) == weight);
+			sort(chosen.begin(), chosen.end());
+			assert(chosen == expected);
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkShortestPath
+//  Description:    shortestPath on random graphs of one-way arcs that
+//                  only go to higher indices, against the reference
+//                  and UCS, with the trace UCS prints showing it was
+//                  not run; then a negative arc only the relaxation in
+//                  topological order gets right, and a graph of dual
+//                  arcs, which has to go to UCS.
+// ----------------------------------------------------------------
+void checkShortestPath()
+{
+	streambuf* pQuiet = cout.rdbuf();
+	for (unsigned int seed = 0; seed < 5; seed++) {
+		int const size = 250;
+		RouteGraph graph(size);
+		mt19937 random(seed);
+		for (int i = 0; i < size; i++) {
+			graph.addNode(pair<string, int>("d" + to_string(i), 0), i);
+		}
+		for (int a = 0; a < size * 4; a++) {
+			int from = random() % size;
+			int to = random() % size;
+			if (from < to) {
+				graph.addArc(from, to, 1 + (int)(random() % 30));
+			}
+		}
+		vector<int> order;
+		assert(graph.topologicalOrder(order));
+		for (int start = 0; start < size; start += 31) {
+			vector<int> cost;
+			referenceCosts(graph, start, cost);
+			for (int target = 0; target < size; target += 7) {
+				stringstream trace;
+				cout.rdbuf(trace.rdbuf());
+				PathResult path;
+				graph.shortestPath(graph.nodeArray()[start], graph.nodeArray()[target], path);
+				cout.rdbuf(pQuiet);
+				assert(trace.str().find("UCS from") == string::npos);
+				assert(path.cost() == cost[target]);
+				PathResult ucs;
+				graph.UCS(graph.nodeArray()[start], graph.nodeArray()[target], NoVisit(), ucs);
+				assert(ucs.cost() == path.cost());
+				if (!path.empty()) {
+					assert(path.nodes.front() == start && path.nodes.back() == target);
+					for (size_t i = 0; i + 1 < path.nodes.size(); i++) {
+						Arc* pArc = graph.getArc(path.nodes[i], path.nodes[i + 1]);
+						assert(pArc != 0 && path.costs[i] + pArc->weight() == path.costs[i + 1]);
+					}
+				}
+			}
+		}
+	}
+
+	RouteGraph negative(3);
+	for (int i = 0; i < 3; i++) {
+		negative.addNode(pair<string, int>("n" + to_string(i), 0), i);
+	}
+	negative.addArc(0, 1, 5);
+	negative.addArc(0, 2, 2);
+	negative.addArc(2, 1, -4);
+	vector<Node*> path;
+	negative.shortestPath(negative.nodeArray()[0], negative.nodeArray()[1], path);
+	assert(path.size() == 3 && path[0]->data().second == -2);
+	assert(negative.indexOf(path[1]) == 2);
+
+	RouteGraph dual(3);
+	for (int i = 0; i < 3; i++) {
+		dual.addNode(pair<string, int>("u" + to_string(i), 0), i);
+	}
+	dual.addDualArc(0, 1, 4);
+	dual.addDualArc(1, 2, 4);
+	stringstream trace;
+	cout.rdbuf(trace.rdbuf());
+	path.clear();
+	dual.shortestPath(dual.nodeArray()[0], dual.nodeArray()[2], path);
+	cout.rdbuf(pQuiet);
+	assert(trace.str().find("UCS from") != string::npos);
+	assert(path.size() == 3 && path[0]->data().second == 8);
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkPath
+//  Description:    Checks a found path runs from start to target over
+//                  real arcs, with running costs that add up to cost.
+//  Arguments:      The graph, the path, its ends and the reference
+//                  cost, INT_MAX if there should be no path.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void checkPath(RouteGraph& graph, PathResult const & path, int start, int target, int cost)
+{
+	if (cost == INT_MAX) {
+		assert(path.empty());
+		return;
+	}
+	assert(!path.empty());
+	assert(path.nodes.front() == start && path.nodes.back() == target);
+	assert(path.costs.front() == 0 && path.cost() == cost);
+	for (int i = 1; i < path.size(); i++) {
+		Arc* pArc = graph.getArc(path.nodes[i - 1], path.nodes[i]);
+		assert(pArc != 0);
+		assert(path.costs[i] - path.costs[i - 1] == pArc->weight());
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkQueue
+//  Description:    UCS with the heap and with the bucket queues, on
+//                  random graphs with weights in a range, against the
+//                  reference, before and after edits that patch the
+//                  packed arcs.
+//  Arguments:      The lightest and heaviest weight, and the seed.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void checkQueue(int minWeight, int maxWeight, unsigned int seed)
+{
+	int const size = 300;
+	RouteGraph* pGraph = randomGraph(size, size * 4, minWeight, maxWeight, seed);
+	Node** pNodes = pGraph->nodeArray();
+	mt19937 random(seed);
+	for (int round = 0; round < 2; round++) {
+		int start = random() % size;
+		while (pNodes[start] == 0) {
+			start = (start + 1) % size;
+		}
+		vector<int> cost;
+		referenceCosts(*pGraph, start, cost);
+		for (int queue = 0; queue < 2; queue++) {
+			pGraph->setSearchQueue(queue == 0 ? QUEUE_HEAP : QUEUE_BUCKET);
+			PathResult path;
+			for (int target = 0; target < size; target += 5) {
+				if (pNodes[target] != 0) {
+					pGraph->UCS(pNodes[start], pNodes[target], NoVisit(), path);
+					checkPath(*pGraph, path, start, target, cost[target]);
+				}
+			}
+		}
+
+		for (int i = 0; i < 40; i++) {
+			int from = random() % size;
+			int to = random() % size;
+			if (from != to && pNodes[from] != 0 && pNodes[to] != 0) {
+				pGraph->removeArc(from, to);
+				pGraph->addArc(to, from, minWeight + (int)(random() % (unsigned int)(maxWeight - minWeight + 1)));
+			}
+		}
+	}
+	delete pGraph;
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkBucketQueues
+//  Description:    Weights for Dial's buckets, with and without zero
+//                  weights and right up to its limit, and weights past
+//                  the limit for the radix heap.
+// ----------------------------------------------------------------
+void checkBucketQueues()
+{
+	int const weights[][2] = { { 1, 20 }, { 0, 20 }, { 1, 65536 }, { 1, 65537 }, { 0, 200000 } };
+	for (unsigned int seed = 0; seed < 3; seed++) {
+		for (int w = 0; w < 5; w++) {
+			checkQueue(weights[w][0], weights[w][1], seed * 5 + w);
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkUniformQueues
+//  Description:    Weights for the FIFO and 0/1 queues, then a graph
+//                  whose only heavy arc is removed and put back, so
+//                  the range the queue is picked from has to follow.
+// ----------------------------------------------------------------
+void checkUniformQueues()
+{
+	int const weights[][2] = { { 1, 1 }, { 7, 7 }, { 0, 0 }, { 0, 1 } };
+	for (unsigned int seed = 0; seed < 3; seed++) {
+		for (int w = 0; w < 4; w++) {
+			checkQueue(weights[w][0], weights[w][1], seed * 4 + w);
+		}
+	}
+
+	RouteGraph graph(4);
+	for (int i = 0; i < 4; i++) {
+		graph.addNode(pair<string, int>("w" + to_string(i), 0), i);
+	}
+	graph.addArc(0, 1, 1);
+	graph.addArc(1, 2, 1);
+	graph.addArc(0, 3, 1);
+	graph.addArc(3, 2, 0);
+	PathResult path;
+	for (int round = 0; round < 3; round++) {
+		graph.UCS(graph.nodeArray()[0], graph.nodeArray()[2], NoVisit(), path);
+		checkPath(graph, path, 0, 2, round == 1 ? 2 : 1);
+		if (round == 0) {
+			graph.removeArc(3, 2);
+			graph.addArc(3, 2, 5);
+		} else {
+			graph.removeArc(3, 2);
+			graph.addArc(3, 2, 0);
+			graph.setOrder(ORDER_INDEX);
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkMemoryStats
+//  Description:    memoryStats against what the graph holds: counts,
+//                  per-part sizes that follow the nodes, arcs and
+//                  long names, the packed and search parts once they
+//                  exist, the total, and the JSON.
+// ----------------------------------------------------------------
+void checkMemoryStats()
+{
+	int const size = 200;
+	RouteGraph* pGraph = randomGraph(size, size * 3, 1, 9, 11);
+	MemoryStats before = pGraph->memoryStats();
+	int arcs = 0;
+	for (int i = 0; i < size; i++) {
+		if (pGraph->nodeArray()[i] != 0) {
+			arcs += (int)pGraph->nodeArray()[i]->arcList().size();
+		}
+	}
+	assert(before.nodeCount == pGraph->count() && before.arcCount == arcs);
+	assert(before.nodeArray == size * sizeof(Node*));
+	assert(before.nodes == pGraph->count() * sizeof(Node));
+	assert(before.payload == 0);
+	assert(before.arcs > 0 && before.arcs % arcs == 0);
+	assert(before.total() == before.nodeArray + before.nodes + before.payload + before.arcs +
+	                         before.indices + before.packed + before.search + before.auxiliary);
+
+	// a long name owns heap memory, an arc costs one list entry, and
+	// searching fills in the packed and search parts.
+	int empty = 0;
+	while (pGraph->nodeArray()[empty] != 0) {
+		empty++;
+	}
+	int from = (empty + 1) % size;
+	while (pGraph->nodeArray()[from] == 0) {
+		from = (from + 1) % size;
+	}
+	pGraph->addNode(pair<string, int>(string(100, 'x'), 0), empty);
+	pGraph->addArc(from, empty, 1);
+	PathResult path;
+	pGraph->UCS(pGraph->nodeArray()[from], pGraph->nodeArray()[empty], NoVisit(), path);
+	MemoryStats after = pGraph->memoryStats();
+	assert(after.nodeCount == before.nodeCount + 1 && after.arcCount == arcs + 1);
+	assert(after.payload >= 101);
+	assert(after.arcs == before.arcs / arcs * (arcs + 1));
+	assert(after.packed > 0 && after.search > 0);
+	assert(after.total() > before.total());
+
+	string json = after.toJson();
+	assert(json.front() == '{' && json.back() == '}');
+	assert(json.find("\"packed\":" + to_string(after.packed) + ",") != string::npos);
+	assert(json.find("\"total\":" + to_string(after.total()) + ",") != string::npos);
+	char const * keys[] = { "nodeArray", "nodes", "payload", "arcs", "indices", "search", "auxiliary",
+	                        "nodeCount", "arcCount", "bytesPerNode", "bytesPerArc" };
+	for (int k = 0; k < 11; k++) {
+		assert(json.find("\"" + string(keys[k]) + "\":") != string::npos);
+	}
+	delete pGraph;
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkSearchStats
+//  Description:    The search counters on a chain, where every figure
+//                  is known, and on random graphs against the nodes
+//                  the reference search reaches and their arcs; and
+//                  nothing counted once the stats are taken away.
+// ----------------------------------------------------------------
+void checkSearchStats()
+{
+	int const length = 1000;
+	RouteGraph chain(length);
+	for (int i = 0; i < length; i++) {
+		chain.addNode(pair<string, int>("s", 0), i);
+	}
+	for (int i = 0; i + 1 < length; i++) {
+		chain.addArc(i, i + 1, 2);
+	}
+	SearchStats stats;
+	chain.setSearchStats(&stats);
+	chain.breadthFirst(chain.nodeArray()[0], NoVisit());
+	assert(stats.settled == length && stats.pushes == length && stats.pops == length);
+	assert(stats.scanned == length - 1 && stats.relaxed == length - 1 && stats.maxQueue == 1);
+	chain.depthFirst(chain.nodeArray()[0], NoVisit());
+	assert(stats.settled == length && stats.pushes == length && stats.pops == length);
+	assert(stats.scanned == length - 1 && stats.maxQueue == length);
+	PathResult path;
+	chain.UCS(chain.nodeArray()[0], chain.nodeArray()[length - 1], NoVisit(), path);
+	assert(stats.settled == length && stats.relaxed == length - 1 && stats.maxQueue == 1);
+
+	for (unsigned int seed = 0; seed < 4; seed++) {
+		int const size = 300;
+		RouteGraph* pGraph = randomGraph(size, size * 3, 1, 30, seed);
+		Node** pNodes = pGraph->nodeArray();
+		int start = (int)seed;
+		while (pNodes[start] == 0) {
+			start++;
+		}
+		vector<int> level;
+		referenceLevels(*pGraph, start, level);
+		long long reached = 0;
+		long long arcs = 0;
+		for (int i = 0; i < size; i++) {
+			if (level[i] != -1) {
+				reached++;
+				arcs += (long long)pNodes[i]->arcList().size();
+			}
+		}
+		pGraph->setSearchStats(&stats);
+		pGraph->breadthFirst(pNodes[start], NoVisit());
+		assert(stats.settled == reached && stats.pushes == reached && stats.pops == reached);
+		assert(stats.scanned == arcs && stats.relaxed == reached - 1);
+		pGraph->depthFirst(pNodes[start], NoVisit());
+		assert(stats.settled == reached && stats.scanned == arcs && stats.pops == reached);
+
+		int target = size - 1;
+		while (pNodes[target] == 0) {
+			target--;
+		}
+		pGraph->UCS(pNodes[start], pNodes[target], NoVisit(), path);
+		assert(stats.settled <= reached && stats.pops >= stats.settled);
+		assert(stats.pushes == stats.relaxed + 1 && stats.scanned <= arcs);
+
+		pGraph->setSearchStats(0);
+		SearchStats before = stats;
+		pGraph->breadthFirst(pNodes[start], NoVisit());
+		assert(stats.settled == before.settled && stats.scanned == before.scanned);
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkSnapshots
+//  Description:    Readers search pinned snapshots while this thread
+//                  edits, searches and publishes the graph. Before each
+//                  publish the reference costs from node 0 are noted by
+//                  version, and every reader answer must match the ones
+//                  for its snapshot's version.
+//  Return Value:   The number of reader queries checked.
+// ----------------------------------------------------------------
+long checkSnapshots()
+{
+	int const size = 300;
+	RouteGraph* pGraph = randomGraph(size, size * 3, 1, 9, 99);
+	Node** pNodes = pGraph->nodeArray();
+	if (pNodes[0] == 0) {
+		pGraph->addNode(pair<string, int>("n0", 0), 0);
+	}
+
+	mutex costsLock;
+	map< unsigned int, vector<int> > costsByVersion;
+	vector<int> cost;
+	referenceCosts(*pGraph, 0, cost);
+	costsByVersion[pGraph->version()] = cost;
+	pGraph->publish();
+
+	atomic<bool> done(false);
+	atomic<long> checked(0);
+	vector<thread> readers;
+	for (int t = 0; t < 4; t++) {
+		readers.push_back(thread([&, t] {
+			mt19937 random(t);
+			PathResult path;
+			while (!done) {
+				shared_ptr< GraphSnapshot<pair<string, int>, int> const > pSnapshot = pGraph->snapshot();
+				vector<int> expected;
+				{
+					lock_guard<mutex> lock(costsLock);
+					expected = costsByVersion[pSnapshot->version()];
+				}
+				int target = random() % size;
+				int found = pSnapshot->UCS(0, target, path);
+				assert(found == expected[target]);
+				for (int i = 0; i < path.size(); i++) {
+					assert(pSnapshot->data(path.nodes[i]).first == "n" + to_string(path.nodes[i]));
+				}
+				checked++;
+			}
+		}));
+	}
+
+	mt19937 random(7);
+	for (int round = 0; round < 200; round++) {
+		for (int i = 0; i < 5; i++) {
+			int from = random() % size;
+			int to = random() % size;
+			if (from != to && pNodes[from] != 0 && pNodes[to] != 0 && pGraph->getArc(from, to) == 0) {
+				pGraph->addArc(from, to, 1 + random() % 9);
+			}
+		}
+		int index = 1 + random() % (size - 1);
+		if (pNodes[index] != 0) {
+			pGraph->removeNode(index);
+		}
+		else {
+			pGraph->addNode(pair<string, int>("n" + to_string(index), 0), index);
+		}
+		// the writer's own searches run alongside the readers'.
+		PathResult path;
+		pGraph->UCS(pNodes[0], pNodes[0], NoVisit(), path);
+		if (round % 3 == 0) {
+			referenceCosts(*pGraph, 0, cost);
+			{
+				lock_guard<mutex> lock(costsLock);
+				costsByVersion[pGraph->version()] = cost;
+			}
+			pGraph->publish();
+		}
+	}
+	done = true;
+	for (size_t t = 0; t < readers.size(); t++) {
+		readers[t].join();
+	}
+	assert(checked > 0);
+
+	// a snapshot outlives the graph it came from.
+	shared_ptr< GraphSnapshot<pair<string, int>, int> const > pLast = pGraph->snapshot();
+	delete pGraph;
+	PathResult path;
+	assert(pLast->UCS(0, 0, path) == 0);
+	return checked.load();
+}
+
+// ----------------------------------------------------------------
+//  Name:           snapshotAnswers
+//  Description:    Works out what the server should send for some
+//                  routes: the cost and appendPath text from the
+//                  snapshot, -1 and no text without a route. One set
+//                  of search arrays is used for all of them, and it
+//                  must be left clean after each.
+//  Arguments:      The snapshot, the routes, and the costs and texts
+//                  to fill in.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void snapshotAnswers(GraphSnapshot<pair<string, int>, int> const & snapshot, vector< pair<int, int> > const & routes,
+                     vector<int>& costs, vector<string>& texts)
+{
+	SnapshotSearch search;
+	costs.assign(routes.size(), -1);
+	texts.assign(routes.size(), string());
+	for (size_t r = 0; r < routes.size(); r++) {
+		PathResult path;
+		int cost = snapshot.UCS(routes[r].first, routes[r].second, path, search);
+		PathResult fresh;
+		assert(snapshot.UCS(routes[r].first, routes[r].second, fresh) == cost);
+		assert(search.touched.empty() && search.heap.empty());
+		assert(count(search.cost.begin(), search.cost.end(), INT_MAX) == (long)search.cost.size());
+		if (cost != INT_MAX) {
+			costs[r] = cost;
+			appendPath(texts[r], path, [&snapshot](int index) -> string const & { return snapshot.data(index).first; });
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkQueryServer
+//  Description:    A server on a local socket, asked by two clients
+//                  at once, including routes between indices that are
+//                  out of range or empty, before and after an edit is
+//                  published. Every reply must carry its own tag, and
+//                  the cost and text the snapshot gives.
+// ----------------------------------------------------------------
+void checkQueryServer()
+{
+	int const size = 200;
+	RouteGraph* pGraph = randomGraph(size, size * 3, 1, 20, 5);
+	Node** pNodes = pGraph->nodeArray();
+	pGraph->publish();
+	string const socketPath = "/tmp/graph_tests_" + to_string(getpid()) + ".sock";
+	QueryServer<pair<string, int>, int>* pServer = new QueryServer<pair<string, int>, int>(*pGraph, socketPath, 3, 8);
+	assert(pServer->start());
+
+	mt19937 random(5);
+	long long asked = 0;
+	for (int round = 0; round < 2; round++) {
+		vector< pair<int, int> > routes[2];
+		for (int c = 0; c < 2; c++) {
+			for (int r = 0; r < 300; r++) {
+				routes[c].push_back(make_pair((int)(random() % (size + 4)) - 2, (int)(random() % (size + 4)) - 2));
+			}
+			routes[c].push_back(make_pair(0, size));
+			routes[c].push_back(make_pair(-1, 0));
+			asked += (long long)routes[c].size();
+		}
+		shared_ptr< GraphSnapshot<pair<string, int>, int> const > pSnapshot = pGraph->snapshot();
+		vector<int> costs[2], expectedCosts[2];
+		vector<string> texts[2], expectedTexts[2];
+		bool ok[2];
+		vector<thread> clients;
+		for (int c = 0; c < 2; c++) {
+			clients.push_back(thread([&, c] {
+				int fd = connectQueryServer(socketPath);
+				ok[c] = fd >= 0 && askQueryServer(fd, routes[c], costs[c], texts[c]);
+				if (fd >= 0) {
+					close(fd);
+				}
+			}));
+		}
+		for (int c = 0; c < 2; c++) {
+			clients[c].join();
+			assert(ok[c]);
+			snapshotAnswers(*pSnapshot, routes[c], expectedCosts[c], expectedTexts[c]);
+			assert(costs[c] == expectedCosts[c] && texts[c] == expectedTexts[c]);
+			assert(costs[c][300] == -1 && costs[c][301] == -1);
+		}
+		assert(count(costs[0].begin(), costs[0].end(), -1) < (long)costs[0].size());
+
+		// a new route for the next round to find.
+		for (int i = 0; i < 20; i++) {
+			int from = random() % size;
+			int to = random() % size;
+			if (from != to && pNodes[from] != 0 && pNodes[to] != 0 && pGraph->getArc(from, to) == 0) {
+				pGraph->addArc(from, to, 1);
+			}
+		}
+		pGraph->publish();
+	}
+	pServer->stop();
+	assert(pServer->answered() == asked);
+	delete pServer;
+	delete pGraph;
+}
+
+// ----------------------------------------------------------------
+//  Name:           walk
+//  Description:    Takes every node from a traversal range through its
+//                  iterators, pruning those at odd indices if asked.
+//  Arguments:      The graph, the range, and whether to prune.
+//  Return Value:   The node indices in the order given.
+// ----------------------------------------------------------------
+template<class Range>
+vector<int> walk(RouteGraph& graph, Range range, bool prune)
+{
+	vector<int> order;
+	for (typename Range::iterator iter = range.begin(); iter != range.end(); ++iter) {
+		int index = graph.indexOf(*iter);
+		order.push_back(index);
+		if (prune && index % 2 == 1) {
+			range.prune();
+		}
+	}
+	return order;
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkRanges
+//  Description:    bfsRange and dfsRange against breadthFirst and
+//                  depthFirst, with and without pruning, two ranges
+//                  side by side, and ranges that carry on over the
+//                  graph as it was while it is edited under them.
+// ----------------------------------------------------------------
+void checkRanges()
+{
+	for (unsigned int seed = 0; seed < 6; seed++) {
+		int const size = 300;
+		RouteGraph* pGraph = randomGraph(size, size * 2, 1, 9, seed);
+		Node** pNodes = pGraph->nodeArray();
+		int start = (int)seed;
+		while (pNodes[start] == 0) {
+			start++;
+		}
+		vector<int> bfs, dfs, pruned;
+		pGraph->breadthFirst(pNodes[start], [&](Node* pNode) { bfs.push_back(pGraph->indexOf(pNode)); });
+		pGraph->depthFirst(pNodes[start], [&](Node* pNode) { dfs.push_back(pGraph->indexOf(pNode)); });
+		PruneOdd prune = { pGraph, &pruned };
+		pGraph->breadthFirst(pNodes[start], prune);
+		assert(walk(*pGraph, pGraph->bfsRange(pNodes[start]), false) == bfs);
+		assert(walk(*pGraph, pGraph->dfsRange(pNodes[start]), false) == dfs);
+		assert(walk(*pGraph, pGraph->bfsRange(pNodes[start]), true) == pruned);
+		assert(walk(*pGraph, pGraph->bfsRange(0), false).empty());
+		assert(walk(*pGraph, pGraph->dfsRange(0), false).empty());
+
+		// two ranges stepped in turn, with edits between the steps.
+		BreadthFirstRange<pair<string, int>, int> breadth = pGraph->bfsRange(pNodes[start]);
+		DepthFirstRange<pair<string, int>, int> depth = pGraph->dfsRange(pNodes[start]);
+		vector<int> byBreadth, byDepth;
+		mt19937 random(seed);
+		while (!breadth.empty() || !depth.empty()) {
+			if (!breadth.empty()) {
+				byBreadth.push_back(pGraph->indexOf(breadth.front()));
+				breadth.next();
+			}
+			if (!depth.empty()) {
+				byDepth.push_back(pGraph->indexOf(depth.front()));
+				depth.next();
+			}
+			int from = random() % size;
+			int to = random() % size;
+			if (from != to && pNodes[from] != 0 && pNodes[to] != 0) {
+				if (pGraph->getArc(from, to) != 0) {
+					pGraph->removeArc(from, to);
+				} else {
+					pGraph->addArc(from, to, 1);
+				}
+			}
+		}
+		assert(byBreadth == bfs && byDepth == dfs);
+
+		// the graph itself moved on.
+		vector<int> after;
+		pGraph->breadthFirst(pNodes[start], [&](Node* pNode) { after.push_back(pGraph->indexOf(pNode)); });
+		assert(walk(*pGraph, pGraph->bfsRange(pNodes[start]), false) == after);
+		delete pGraph;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           checkPathText
+//  Description:    Writes the paths main finds in the lab graph, the
+//                  nodes and arcs of dornodes.txt and dorarcs.txt, and
+//                  compares the text byte for byte with what main
+//                  printed before PathWriter. The writer gets a small
+//                  buffer so it fills mid-path. appendPath into a
+//                  string, as the query server writes, must match too.
+// ----------------------------------------------------------------
+void checkPathText()
+{
+	char const* names[] = { "Aldar", "Boldar", "Coldar", "Daldar", "Eldar", "Foldar" };
+	int const arcs[][3] = { { 0, 1, 40 }, { 0, 2, 30 }, { 1, 3, 5 }, { 2, 3, 20 }, { 3, 5, 50 }, { 4, 5, 10 }, { 4, 1, 35 } };
+	char const* expected =
+		"-----\n"
+		"=====PP\n[Aldar-Boldar] [40]\nAldar(0)->Boldar(40)\n=====\n\n"
+		"=====PP\n[Aldar-Coldar] [30]\nAldar(0)->Coldar(30)\n=====\n\n"
+		"=====PP\n[Aldar-Daldar] [45]\nAldar(0)->Boldar(40)->Daldar(5)\n=====\n\n"
+		"=====PP\n[Aldar-Eldar] [75]\nAldar(0)->Boldar(40)->Eldar(35)\n=====\n\n"
+		"=====PP\n[Aldar-Foldar] [85]\nAldar(0)->Boldar(40)->Eldar(35)->Foldar(10)\n=====\n\n"
+		"=====PP\n[Boldar-Coldar] [25]\nBoldar(0)->Daldar(5)->Coldar(20)\n=====\n\n"
+		"=====PP\n[Boldar-Daldar] [5]\nBoldar(0)->Daldar(5)\n=====\n\n"
+		"=====PP\n[Boldar-Eldar] [35]\nBoldar(0)->Eldar(35)\n=====\n\n"
+		"=====PP\n[Boldar-Foldar] [45]\nBoldar(0)->Eldar(35)->Foldar(10)\n=====\n\n"
+		"=====PP\n[Coldar-Daldar] [20]\nColdar(0)->Daldar(20)\n=====\n\n"
+		"=====PP\n[Coldar-Eldar] [60]\nColdar(0)->Daldar(20)->Boldar(5)->Eldar(35)\n=====\n\n"
+		"=====PP\n[Coldar-Foldar] [70]\nColdar(0)->Daldar(20)->Foldar(50)\n=====\n\n"
+		"=====PP\n[Daldar-Eldar] [40]\nDaldar(0)->Boldar(5)->Eldar(35)\n=====\n\n"
+		"=====PP\n[Daldar-Foldar] [50]\nDaldar(0)->Foldar(50)\n=====\n\n"
+		"=====PP\n[Eldar-Foldar] [10]\nEldar(0)->Foldar(10)\n=====\n\n";
+
+	RouteGraph graph(6);
+	for (int i = 0; i < 6; i++) {
+		graph.addNode(pair<string, int>(names[i], 0), i);
+	}
+	for (int i = 0; i < 7; i++) {
+		graph.addDualArc(arcs[i][0], arcs[i][1], arcs[i][2]);
+	}
+
+	ostringstream written;
+	string appended = "-----\n";
+	{
+		PathWriter<pair<string, int>, int> writer(graph, written, 16);
+		writer.write("-----\n");
+		PathResult path;
+		for (int o = 0; o < 5; o++) {
+			for (int n = o + 1; n <= 5; n++) {
+				graph.shortestPath(graph.nodeArray()[o], graph.nodeArray()[n], path);
+				writer.write(path);
+				appendPath(appended, path, [&graph](int index) -> string const & { return graph.nodeArray()[index]->data().first; });
+			}
+		}
+	}
+	assert(written.str() == expected);
+	assert(appended == expected);
+}
+
+// ----------------------------------------------------------------
+//  Name:           main
+//  Description:    Runs every check; a failed check aborts. Build it
+//                  without NDEBUG, and under the thread sanitizer to
+//                  check the parallel code too, e.g.
+//                      g++ -std=c++17 -g -O1 -fsanitize=thread -pthread
+//                          tests.cpp -o tests
+// ----------------------------------------------------------------
+int main()
+{
+	// the searches trace themselves to cout; only the results are wanted.
+	streambuf* pTrace = cout.rdbuf(0);
+	ostream out(pTrace);
+
+	checkDepthFirst();
+	out << "Depth-first order matches the recursive search" << endl;
+	checkHybridBreadthFirst();
+	out << "Hybrid breadth-first levels match the reference" << endl;
+	checkParallelBreadthFirst();
+	out << "Parallel breadth-first levels match the reference" << endl;
+	checkMultiSource();
+	out << "Multi-source hop counts match the reference" << endl;
+	checkVisitors();
+	out << "Visitors prune and stop as asked" << endl;
+	checkDeltaStepping();
+	out << "Delta-stepping costs match the reference" << endl;
+	checkDynamicShortestPaths();
+	out << "Repaired shortest paths match fresh searches" << endl;
+	checkPathCache();
+	out << "Cached paths match the reference" << endl;
+	checkUCSMany();
+	out << "UCSMany costs and paths match the reference" << endl;
+	checkUCSRange();
+	out << "UCSRange finds the nodes within budget" << endl;
+	checkNodeOrders();
+	out << "Reordered graphs search the same" << endl;
+	checkCompressedGraph();
+	out << "Compressed arcs round trip and search the same" << endl;
+	checkEdits();
+	out << "Edits check their nodes and keep components right" << endl;
+	checkStrongComponents();
+	out << "Strong components match mutual reachability" << endl;
+	checkSpanningForest();
+	out << "Spanning forests match Kruskal" << endl;
+	checkShortestPath();
+	out << "Acyclic shortest paths skip the queue and match the reference" << endl;
+	checkBucketQueues();
+	out << "Dial and radix heap searches match the reference" << endl;
+	checkUniformQueues();
+	out << "FIFO and 0/1 searches match the reference" << endl;
+	checkMemoryStats();
+	out << "Memory figures follow the graph" << endl;
+	checkSearchStats();
+	out << "Search counters add up" << endl;
+	long queries = checkSnapshots();
+	out << "Snapshots agreed on " << queries << " reader queries" << endl;
+	checkQueryServer();
+	out << "Query server replies match the snapshot" << endl;
+	checkRanges();
+	out << "Traversal ranges match the traversals" << endl;
+	checkPathText();
+	out << "Path text matches main's" << endl;
+
+	cout.rdbuf(pTrace);
+	cout << "All tests passed" << endl;
+	return 0;
+}